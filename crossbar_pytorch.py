@@ -20,38 +20,33 @@ import memristorsim
 
 class CrossbarFunction(torch.autograd.Function):
     @staticmethod
-    def forward(ctx, x, weight, crossbar):
+    def forward(ctx, x, weight, crossbar, read_only=False, pool=None):
         """
         Forward VMM pass using the physical C++ Crossbar solver.
         - x: [batch_size, 8] input activations mapped to row voltages
         - weight: [8, 8] synaptic weights mapped to conductances w (0.0 to 1.0)
-        - crossbar: The CrossbarArray C++ instance
+        - crossbar: The CrossbarArray (or TiledMatrix) C++ instance
+        - read_only: read the programmed devices without evolving their physical state
+        - pool: optional CrossbarPool that shards the batch across worker replicas of `crossbar`
         """
         ctx.save_for_backward(x, weight)
         
-        batch_size = x.shape[0]
         device = x.device
         
-        # Output tensor of currents: [batch_size, 8]
-        out_currents = torch.zeros((batch_size, 8), device=device)
-        
-        # Program weights into C++ crossbar array cells
-        w_np = weight.detach().cpu().numpy()
-        for r in range(8):
-            for c in range(8):
-                crossbar.program_cell(r, c, float(np.clip(w_np[r, c], 0.0, 1.0)))
-        
-        # Run C++ solver for each vector in the batch
-        x_np = x.detach().cpu().numpy()
-        for b in range(batch_size):
-            row_voltages = [float(val) for val in x_np[b, :]]
-            crossbar.set_inputs(row_voltages)
-            crossbar.update(0.001)  # step forward dt=1ms
-            
-            # Read output currents from bitlines
-            out_currents[b, :] = torch.tensor(crossbar.outputs(), device=device)
-            
-        return out_currents
+        # Program weights into C++ crossbar array cells in one call
+        w_np = np.ascontiguousarray(weight.detach().cpu().clamp(0.0, 1.0).numpy())
+        crossbar.program_matrix(w_np)
+        
+        # Run the whole batch through the C++ solver in one call (dt=1ms per sample)
+        x_np = np.ascontiguousarray(x.detach().cpu().numpy(), dtype=np.float64)
+        if pool is not None:
+            pool.sync(crossbar)
+            out_np = pool.forward_batch(x_np, 0.001, read_only)
+        else:
+            out_np = crossbar.forward_batch(x_np, 0.001, read_only)
+        
+        # Output tensor of bitline currents: [batch_size, out_features]
+        return torch.from_numpy(out_np).to(device=device, dtype=x.dtype)
 
     @staticmethod
     def backward(ctx, grad_output):
@@ -73,11 +68,13 @@ class CrossbarFunction(torch.autograd.Function):
         if ctx.needs_input_grad[1]:
             grad_weight = torch.matmul(x.t(), grad_output)
             
-        return grad_input, grad_weight, None
+        return grad_input, grad_weight, None, None, None
         
 class CrossbarLinear(torch.nn.Module):
-    def __init__(self, enable_ir_drop=False, r_wire=1.5, enable_dac=False, dac_bits=8, enable_adc=False, adc_bits=8):
+    def __init__(self, enable_ir_drop=False, r_wire=1.5, enable_dac=False, dac_bits=8, enable_adc=False, adc_bits=8, read_only=False, workers=1):
         super(CrossbarLinear, self).__init__()
+        self.read_only = read_only
+        self.workers = workers
         # Trainable weights: initialized in range [-1.0, 1.0] for signed weights representation
         self.weight = torch.nn.Parameter(torch.rand(8, 8) * 2.0 - 1.0)
         
@@ -93,6 +90,15 @@ class CrossbarLinear(torch.nn.Module):
             cb.set_enable_adc(enable_adc)
             cb.set_adc_bits(adc_bits)
         
+        # workers != 1 shards each batch across a CrossbarPool (0 = one worker per core); the
+        # G+ and G- pools run one after the other, so they share one set of threads
+        self.pool_pos = None
+        self.pool_neg = None
+        if workers != 1:
+            threads = memristorsim.ThreadPool(workers)
+            self.pool_pos = memristorsim.CrossbarPool(self.crossbar_pos, threads)
+            self.pool_neg = memristorsim.CrossbarPool(self.crossbar_neg, threads)
+        
     def forward(self, x):
         # Enforce batch layout checks
         if x.shape[-1] != 8:
@@ -106,8 +112,8 @@ class CrossbarLinear(torch.nn.Module):
         weight_neg = torch.clamp(-self.weight, min=0.0)
         
         # Run forward evaluations on both positive and negative physical arrays
-        out_pos = CrossbarFunction.apply(x_flat, weight_pos, self.crossbar_pos)
-        out_neg = CrossbarFunction.apply(x_flat, weight_neg, self.crossbar_neg)
+        out_pos = CrossbarFunction.apply(x_flat, weight_pos, self.crossbar_pos, self.read_only, self.pool_pos)
+        out_neg = CrossbarFunction.apply(x_flat, weight_neg, self.crossbar_neg, self.read_only, self.pool_neg)
         
         # Net output current is the differential: I_net = I+ - I-
         y_flat = out_pos - out_neg
@@ -115,3 +121,69 @@ class CrossbarLinear(torch.nn.Module):
         # Reshape to original batch dimensions
         new_shape = list(orig_shape[:-1]) + [8]
         return y_flat.view(*new_shape)
+
+class TiledCrossbarLinear(torch.nn.Module):
+    """
+    Hardware-aware linear layer of arbitrary size (in_features x out_features) mapped onto a grid
+    of fixed-size crossbar tiles by the C++ TiledMatrix engine. Tiles run in parallel and their
+    ADC-quantized partial sums are accumulated digitally. Signed weights use a G+ / G- pair of engines.
+    """
+    def __init__(self, in_features, out_features, tile_rows=64, tile_cols=64, enable_ir_drop=False, r_wire=1.5,
+                 enable_dac=False, dac_bits=8, enable_adc=False, adc_bits=8, read_only=False, workers=0):
+        super(TiledCrossbarLinear, self).__init__()
+        self.in_features = in_features
+        self.out_features = out_features
+        self.read_only = read_only
+        self.weight = torch.nn.Parameter(torch.rand(in_features, out_features) * 2.0 - 1.0)
+        
+        # Both engines run on one ThreadPool (0 = one thread per core) instead of one each
+        threads = memristorsim.ThreadPool(workers)
+        self.engine_pos = memristorsim.TiledMatrix(in_features, out_features, tile_rows, tile_cols, threads)
+        self.engine_neg = memristorsim.TiledMatrix(in_features, out_features, tile_rows, tile_cols, threads)
+        self.set_enable_ir_drop(enable_ir_drop)
+        self.set_r_wire(r_wire)
+        for engine in self.engines():
+            engine.set_enable_dac(enable_dac)
+            engine.set_dac_bits(dac_bits)
+            engine.set_enable_adc(enable_adc)
+            engine.set_adc_bits(adc_bits)
+    
+    def engines(self):
+        return [self.engine_pos, self.engine_neg]
+    
+    def set_enable_ir_drop(self, val):
+        for engine in self.engines():
+            engine.set_enable_ir_drop(val)
+    
+    def set_r_wire(self, r):
+        for engine in self.engines():
+            engine.set_r_wire(r)
+    
+    def set_enable_adc(self, val):
+        for engine in self.engines():
+            engine.set_enable_adc(val)
+    
+    def set_adc_bits(self, bits):
+        for engine in self.engines():
+            engine.set_adc_bits(bits)
+    
+    def tile_latency_ms(self):
+        """Per-tile wall-clock time (ms) of the last forward pass for the G+ and G- engines."""
+        return self.engine_pos.tile_latency_ms(), self.engine_neg.tile_latency_ms()
+    
+    def forward(self, x):
+        if x.shape[-1] != self.in_features:
+            raise ValueError(f"TiledCrossbarLinear inputs must have shape [..., {self.in_features}]")
+        
+        orig_shape = x.shape
+        x_flat = x.reshape(-1, self.in_features)
+        
+        weight_pos = torch.clamp(self.weight, min=0.0)
+        weight_neg = torch.clamp(-self.weight, min=0.0)
+        
+        out_pos = CrossbarFunction.apply(x_flat, weight_pos, self.engine_pos, self.read_only)
+        out_neg = CrossbarFunction.apply(x_flat, weight_neg, self.engine_neg, self.read_only)
+        
+        y_flat = out_pos - out_neg
+        new_shape = list(orig_shape[:-1]) + [self.out_features]
+        return y_flat.view(*new_shape)
@@ -69,12 +69,14 @@ def load_mnist_data():
 class HardwareAwareClassifier(nn.Module):
     def __init__(self, enable_ir_drop=True, r_wire=1.5, enable_dac=True, enable_adc=True):
         super(HardwareAwareClassifier, self).__init__()
-        # Feature extractor with 128 hidden nodes projecting down to 8 bottleneck dimensions
+        # Feature extractor with 128 hidden nodes
         self.fc1 = nn.Linear(784, 128)
-        self.fc_compress = nn.Linear(128, 8)
         
-        # Layer 2: Hardware-Bottleneck Memristive Crossbar Layer (8x8 signed weights)
-        self.crossbar_layer = crossbar_pytorch.CrossbarLinear(
+        # Layer 2: Memristive Crossbar Layer (128x32 signed weights tiled over 32x32 crossbars)
+        self.crossbar_layer = crossbar_pytorch.TiledCrossbarLinear(
+            128, 32,
+            tile_rows=32,
+            tile_cols=32,
             enable_ir_drop=enable_ir_drop,
             r_wire=r_wire,
             enable_dac=enable_dac,
@@ -84,14 +86,13 @@ class HardwareAwareClassifier(nn.Module):
         )
         
         # Batch normalization layer to stabilize physical currents output scale
-        self.bn = nn.BatchNorm1d(8)
+        self.bn = nn.BatchNorm1d(32)
         
-        # Layer 3: Output mapper (converts 8 features to 10 class logits)
-        self.fc2 = nn.Linear(8, 10)
+        # Layer 3: Output mapper (converts 32 features to 10 class logits)
+        self.fc2 = nn.Linear(32, 10)
         
     def forward(self, x):
         x = torch.relu(self.fc1(x))
-        x = torch.relu(self.fc_compress(x))
         x = self.bn(self.crossbar_layer(x))  # Automatically normalizes physical currents scale
         x = self.fc2(x)
         return x
@@ -144,6 +145,9 @@ if __name__ == "__main__":
     # Run training
     train_model(model, train_loader, test_loader, epochs=5)
     
+    lat_pos, lat_neg = model.crossbar_layer.tile_latency_ms()
+    print(f"Per-tile latency of the last batch (G+ engine, ms):\n{np.round(lat_pos, 3)}")
+    
     print("\n=======================================================")
     print("      RESEARCH CASE STUDY: CO-DESIGN SWEEPS            ")
     print("=======================================================")
@@ -154,13 +158,10 @@ if __name__ == "__main__":
     r_wire_values = [0.0, 0.5, 1.5, 3.0, 6.0, 10.0]
     for r in r_wire_values:
         if r == 0.0:
-            model.crossbar_layer.crossbar_pos.set_enable_ir_drop(False)
-            model.crossbar_layer.crossbar_neg.set_enable_ir_drop(False)
+            model.crossbar_layer.set_enable_ir_drop(False)
         else:
-            model.crossbar_layer.crossbar_pos.set_enable_ir_drop(True)
-            model.crossbar_layer.crossbar_neg.set_enable_ir_drop(True)
-            model.crossbar_layer.crossbar_pos.set_r_wire(r)
-            model.crossbar_layer.crossbar_neg.set_r_wire(r)
+            model.crossbar_layer.set_enable_ir_drop(True)
+            model.crossbar_layer.set_r_wire(r)
             
         acc = evaluate_model(model, test_loader)
         marker = " [Ideal Base]" if r == 0.0 else ""
@@ -170,17 +171,13 @@ if __name__ == "__main__":
     print("\nSweep B: Impact of ADC Bit Resolution on Model Accuracy")
     print("-------------------------------------------------------")
     # Reset wire resistance to 1.5 Ohm for this sweep
-    model.crossbar_layer.crossbar_pos.set_enable_ir_drop(True)
-    model.crossbar_layer.crossbar_neg.set_enable_ir_drop(True)
-    model.crossbar_layer.crossbar_pos.set_r_wire(1.5)
-    model.crossbar_layer.crossbar_neg.set_r_wire(1.5)
+    model.crossbar_layer.set_enable_ir_drop(True)
+    model.crossbar_layer.set_r_wire(1.5)
     
     adc_bits = [8, 4, 3, 2, 1]
     for bits in adc_bits:
-        model.crossbar_layer.crossbar_pos.set_enable_adc(True)
-        model.crossbar_layer.crossbar_neg.set_enable_adc(True)
-        model.crossbar_layer.crossbar_pos.set_adc_bits(bits)
-        model.crossbar_layer.crossbar_neg.set_adc_bits(bits)
+        model.crossbar_layer.set_enable_adc(True)
+        model.crossbar_layer.set_adc_bits(bits)
         
         acc = evaluate_model(model, test_loader)
         marker = " [Binary Search/Quantized]" if bits == 1 else ""
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "physics/Memristor.h"
+#include "physics/Crossbar.h"
+#include "physics/Optimizer.h"
+#include "utils/CounterRng.h"
+#include "utils/Waveform.h"
+
+// Microbenchmarks of the simulation hot paths, written as one JSON document so runs can be
+// compared across releases and machines. Every benchmark reports the median, minimum and
+// maximum of several repeats; a repeat runs the operation often enough to last --min-time.
+
+#ifndef MEMRISTORSIM_BENCH_CONFIG
+#define MEMRISTORSIM_BENCH_CONFIG ""
+#endif
+
+using Json = nlohmann::ordered_json;
+using Clock = std::chrono::steady_clock;
+
+static void print_usage() {
+    std::cerr << "Usage: memristor_bench [options]\n"
+                 "\n"
+                 "  --out FILE      write the JSON report to FILE (default: stdout)\n"
+                 "  --filter TEXT   run only benchmarks whose name contains TEXT\n"
+                 "  --quick         fewer sizes, repeats and a shorter --min-time, for smoke tests\n"
+                 "  --min-time s    minimum duration of one repeat (default 0.25)\n"
+                 "  --repeats N     repeats per benchmark (default 5)\n"
+                 "  --label TEXT    free-form tag stored in the report, e.g. a release or commit\n"
+                 "  --list          print the benchmark names and exit\n";
+}
+
+struct Settings {
+    double min_time = 0.25;
+    int repeats = 5;
+    bool quick = false;
+    std::string filter;
+};
+
+struct Measurement {
+    double median = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    long long iterations = 0;   // Operations per repeat
+};
+
+// Calls run(n), which performs n operations, with n grown until one call lasts min_time, then
+// times `repeats` calls. Values are seconds per operation.
+static Measurement measure(const std::function<void(long long)>& run, const Settings& s) {
+    auto time = [&](long long n) {
+        auto start = Clock::now();
+        run(n);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+    long long n = 1;
+    double t = time(n);
+    while (t < s.min_time) {
+        double grow = t > 0.0 ? 1.2 * s.min_time / t : 10.0;
+        n = std::max(n + 1, (long long)(n * std::min(grow, 10.0)));
+        t = time(n);
+    }
+    std::vector<double> per_op;
+    per_op.push_back(t / (double)n);
+    for (int r = 1; r < s.repeats; ++r) per_op.push_back(time(n) / (double)n);
+    std::sort(per_op.begin(), per_op.end());
+    Measurement m;
+    m.median = per_op[per_op.size() / 2];
+    m.min = per_op.front();
+    m.max = per_op.back();
+    m.iterations = n;
+    return m;
+}
+
+// One entry of the report; value/min/max are in `unit`
+static Json entry(const std::string& name, const Json& params, const Measurement& m, const char* unit, double scale) {
+    Json e;
+    e["name"] = name;
+    e["params"] = params;
+    e["unit"] = unit;
+    e["value"] = m.median * scale;
+    e["min"] = m.min * scale;
+    e["max"] = m.max * scale;
+    e["iterations"] = m.iterations;
+    return e;
+}
+
+class Suite {
+public:
+    explicit Suite(const Settings& s) : m_settings(s) {}
+
+    bool selected(const std::string& name) const {
+        return m_settings.filter.empty() || name.find(m_settings.filter) != std::string::npos;
+    }
+    void add(Json e) {
+        std::cerr << "  " << e["name"].get<std::string>() << ": " << e["value"].get<double>() << " "
+                  << e["unit"].get<std::string>() << "\n";
+        m_results.push_back(std::move(e));
+    }
+    const Settings& settings() const { return m_settings; }
+    Json& results() { return m_results; }
+
+private:
+    Settings m_settings;
+    Json m_results = Json::array();
+};
+
+static const char* model_name(ConductionModel m) {
+    switch (m) {
+        case ConductionModel::Sinh: return "sinh";
+        case ConductionModel::PooleFrenkel: return "poole_frenkel";
+        case ConductionModel::Schottky: return "schottky";
+    }
+    return "";
+}
+
+static const char* integrator_name(IntegratorMode m) {
+    switch (m) {
+        case IntegratorMode::RK4: return "rk4";
+        case IntegratorMode::BogackiShampine: return "bs";
+        case IntegratorMode::DormandPrince: return "dp";
+    }
+    return "";
+}
+
+// PhysicsEngine::update under a 100 Hz, 1.5 V sine, in every conduction model and selector mode
+static void bench_physics(Suite& suite, std::vector<std::string>* names) {
+    const double dt = 1e-5;
+    const char* selectors[] = {"none", "1s1r", "1t1r"};
+    for (ConductionModel model : {ConductionModel::Sinh, ConductionModel::PooleFrenkel, ConductionModel::Schottky}) {
+        for (int sel = 0; sel < 3; ++sel) {
+            std::string name = std::string("physics_update/") + model_name(model) + "/" + selectors[sel];
+            if (names) { names->push_back(name); continue; }
+            if (!suite.selected(name)) continue;
+
+            MemristorParams p;
+            p.conduction_model = model;
+            p.enable_selector = sel > 0;
+            p.selector_type = sel > 0 ? sel - 1 : 0;
+            PhysicsEngine engine(p);
+            WaveformGenerator waveform;
+            waveform.set_waveform(Waveform::Sine);
+            waveform.set_amplitude(1.5);
+            waveform.set_frequency(100.0);
+            double t = 0.0;
+            Measurement m = measure([&](long long n) {
+                for (long long k = 0; k < n; ++k) {
+                    t += dt;
+                    engine.update(dt, waveform.get_voltage(t));
+                }
+            }, suite.settings());
+            Json params = {{"conduction_model", model_name(model)}, {"selector", selectors[sel]},
+                           {"integrator", integrator_name(p.integrator)}, {"dt", dt}};
+            suite.add(entry(name, params, m, "ns/step", 1e9));
+        }
+    }
+}
+
+// CrossbarArray::update of a read (0.2 V on every row, random weights) at several sizes
+static void bench_crossbar(Suite& suite, std::vector<std::string>* names) {
+    std::vector<int> sizes = suite.settings().quick ? std::vector<int>{8, 32} : std::vector<int>{8, 32, 64, 128};
+    struct Mode { const char* name; bool ir_drop; NodalSolverMode solver; };
+    const Mode modes[] = {{"ideal", false, NodalSolverMode::GaussSeidel},
+                          {"ir_drop_gs", true, NodalSolverMode::GaussSeidel},
+                          {"ir_drop_newton", true, NodalSolverMode::Newton}};
+    const double dt = 1e-3;
+    for (int n : sizes) {
+        for (const Mode& mode : modes) {
+            std::string name = "crossbar_update/" + std::to_string(n) + "x" + std::to_string(n) + "/" + mode.name;
+            if (names) { names->push_back(name); continue; }
+            if (!suite.selected(name)) continue;
+
+            CrossbarArray xbar(n, n);
+            xbar.set_enable_ir_drop(mode.ir_drop);
+            xbar.set_solver_mode(mode.solver);
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<double> dist(0.0, 1.0);
+            std::vector<double> w((size_t)n * n);
+            for (double& x : w) x = dist(rng);
+            xbar.program_matrix(w.data());
+            xbar.set_inputs(std::vector<double>((size_t)n, 0.2));
+            Measurement m = measure([&](long long steps) {
+                for (long long k = 0; k < steps; ++k) xbar.update(dt);
+            }, suite.settings());
+            Json params = {{"rows", n}, {"cols", n}, {"ir_drop", mode.ir_drop},
+                           {"solver", mode.solver == NodalSolverMode::Newton ? "newton" : "gs"},
+                           {"r_wire", xbar.r_wire()}, {"dt", dt}};
+            Json e = entry(name, params, m, "us/update", 1e6);
+            e["ns_per_cell"] = m.median * 1e9 / ((double)n * n);
+            suite.add(std::move(e));
+        }
+    }
+}
+
+// Closed-loop write-verify of a freshly reset array towards random targets
+static void bench_write_verify(Suite& suite, std::vector<std::string>* names) {
+    const int n = 32;
+    const double tolerance = 0.01;
+    std::string name = "write_verify/" + std::to_string(n) + "x" + std::to_string(n);
+    if (names) { names->push_back(name); return; }
+    if (!suite.selected(name)) return;
+
+    CrossbarArray xbar(n, n);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<double> targets((size_t)n * n);
+    for (double& x : targets) x = dist(rng);
+    std::pair<int, double> last{0, 0.0};
+    Measurement m = measure([&](long long arrays) {
+        for (long long k = 0; k < arrays; ++k) {
+            xbar.reset();
+            last = xbar.program_matrix_write_verify(targets.data(), tolerance);
+        }
+    }, suite.settings());
+    double cells = (double)n * n;
+    Json params = {{"rows", n}, {"cols", n}, {"tolerance", tolerance}};
+    Json e = entry(name, params, m, "us/cell", 1e6 / cells);
+    e["cells_per_second"] = cells / m.median;
+    e["pulses_per_cell"] = last.first / cells;
+    e["energy_per_cell_j"] = last.second / cells;
+    suite.add(std::move(e));
+}
+
+// MemristorFitter::Fit wall time on a synthetic trace of a device with known parameters
+static void bench_fit(Suite& suite, std::vector<std::string>* names) {
+    struct Method { const char* name; FitMethod method; };
+    const Method methods[] = {{"nm", FitMethod::NelderMead},
+                              {"de", FitMethod::DifferentialEvolution},
+                              {"lm", FitMethod::LevenbergMarquardt}};
+    const size_t points = suite.settings().quick ? 2000 : 20000;
+
+    std::vector<FitDataPoint> dataset;
+    for (const Method& method : methods) {
+        std::string name = std::string("fit/") + method.name;
+        if (names) { names->push_back(name); continue; }
+        if (!suite.selected(name)) continue;
+
+        if (dataset.empty()) {
+            MemristorParams truth;
+            truth.enable_read_noise = false;
+            truth.R_on = 250.0;
+            truth.R_off = 16000.0;
+            truth.k_on *= 2.0;
+            PhysicsEngine engine(truth);
+            WaveformGenerator waveform;
+            waveform.set_waveform(Waveform::Sine);
+            waveform.set_amplitude(1.5);
+            waveform.set_frequency(1.0);
+            double dt = 4.0 / (double)points;   // Four periods
+            for (size_t k = 1; k <= points; ++k) {
+                double t = (double)k * dt;
+                double v = waveform.get_voltage(t);
+                engine.update(dt, v);
+                dataset.push_back({t, v, engine.i()});
+            }
+        }
+
+        FitOptions options;
+        options.method = method.method;
+        double mse = 0.0;
+        // One fit is long enough to time on its own
+        Settings once = suite.settings();
+        once.min_time = 0.0;
+        once.repeats = suite.settings().quick ? 1 : 3;
+        Measurement m = measure([&](long long runs) {
+            for (long long k = 0; k < runs; ++k) MemristorFitter::Fit(dataset, MemristorParams(), mse, options);
+        }, once);
+        Json params = {{"method", method.name}, {"points", dataset.size()}, {"parameters", "r,k"},
+                       {"threads", std::thread::hardware_concurrency()}};
+        Json e = entry(name, params, m, "s", 1.0);
+        e["mse"] = mse;
+        suite.add(std::move(e));
+    }
+}
+
+static std::string utc_timestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &now);
+#else
+    gmtime_r(&now, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return buf;
+}
+
+static std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    }
+    return "";
+}
+
+static std::string compiler() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "";
+#endif
+}
+
+int main(int argc, char** argv) {
+    Settings settings;
+    std::string out_path;
+    std::string label;
+    bool list = false;
+    bool min_time_set = false;
+    bool repeats_set = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        bool has_value = i + 1 < argc;
+        if (key == "--help" || key == "-h") { print_usage(); return 0; }
+        else if (key == "--quick") settings.quick = true;
+        else if (key == "--list") list = true;
+        else if (key == "--out" && has_value) out_path = argv[++i];
+        else if (key == "--filter" && has_value) settings.filter = argv[++i];
+        else if (key == "--label" && has_value) label = argv[++i];
+        else if (key == "--min-time" && has_value) { settings.min_time = std::atof(argv[++i]); min_time_set = true; }
+        else if (key == "--repeats" && has_value) { settings.repeats = std::max(1, std::atoi(argv[++i])); repeats_set = true; }
+        else {
+            std::cerr << "Unknown or incomplete option '" << key << "'\n";
+            print_usage();
+            return 1;
+        }
+    }
+    if (settings.quick) {
+        if (!min_time_set) settings.min_time = 0.05;
+        if (!repeats_set) settings.repeats = 3;
+    }
+
+    using BenchFn = void (*)(Suite&, std::vector<std::string>*);
+    const BenchFn benches[] = {bench_physics, bench_crossbar, bench_write_verify, bench_fit};
+
+    Suite suite(settings);
+    if (list) {
+        std::vector<std::string> names;
+        for (BenchFn b : benches) b(suite, &names);
+        for (const auto& n : names) std::cout << n << "\n";
+        return 0;
+    }
+
+    // Fixed noise streams, so every run sees the same read noise and fit dataset
+    CounterRng::SetGlobalSeed(42);
+    std::cerr << "memristor_bench" << (settings.quick ? " (quick)" : "") << "\n";
+    for (BenchFn b : benches) b(suite, nullptr);
+
+    Json report;
+    report["schema"] = 1;
+    report["tool"] = "memristor_bench";
+    report["label"] = label;
+    report["timestamp"] = utc_timestamp();
+    report["build"] = {{"compiler", compiler()},
+                       {"config", MEMRISTORSIM_BENCH_CONFIG},
+#ifdef NDEBUG
+                       {"assertions", false},
+#else
+                       {"assertions", true},
+#endif
+                       {"pointer_bits", sizeof(void*) * 8}};
+    report["host"] = {{"cpu", cpu_model()}, {"hardware_threads", std::thread::hardware_concurrency()}};
+    report["settings"] = {{"min_time_s", settings.min_time}, {"repeats", settings.repeats},
+                          {"quick", settings.quick}, {"filter", settings.filter}};
+    report["benchmarks"] = suite.results();
+
+    std::string text = report.dump(2) + "\n";
+    if (out_path.empty()) {
+        std::cout << text;
+        return 0;
+    }
+    std::ofstream out(out_path);
+    if (!out.is_open()) {
+        std::cerr << "Could not open output file: " << out_path << "\n";
+        return 1;
+    }
+    out << text;
+    return out ? 0 : 1;
+}
@@ -1,13 +1,134 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include <stdexcept>
+#include <string>
 #include "physics/Memristor.h"
 #include "physics/Crossbar.h"
+#include "physics/CrossbarPool.h"
+#include "physics/TiledMatrix.h"
+#include "physics/MonteCarloEnsemble.h"
+#include "utils/Waveform.h"
 
 namespace py = pybind11;
 
+// C-contiguous typed view; NumPy arrays that already match are passed through without a copy
+template <typename T>
+using ScalarArray = py::array_t<T, py::array::c_style | py::array::forcecast>;
+using DoubleArray = ScalarArray<double>;
+
+// Hands a rows x cols weight buffer to `program` as a typed row-major pointer. C-contiguous
+// float32/float64 buffers are read in place; anything else is converted to float64 first.
+template <typename Fn>
+static auto with_weight_matrix(int rows, int cols, py::buffer W, Fn&& program) {
+    py::buffer_info info = W.request();
+    if (info.ndim != 2 || info.shape[0] != rows || info.shape[1] != cols) {
+        throw std::invalid_argument("weight matrix must have shape (" + std::to_string(rows) + ", " +
+                                    std::to_string(cols) + ")");
+    }
+    bool contiguous = info.strides[1] == info.itemsize && info.strides[0] == info.itemsize * info.shape[1];
+    if (contiguous && info.format == py::format_descriptor<float>::format()) {
+        const float* w = static_cast<const float*>(info.ptr);
+        py::gil_scoped_release release;
+        return program(w);
+    }
+    if (contiguous && info.format == py::format_descriptor<double>::format()) {
+        const double* w = static_cast<const double*>(info.ptr);
+        py::gil_scoped_release release;
+        return program(w);
+    }
+    DoubleArray converted = DoubleArray::ensure(W);
+    if (!converted) throw std::invalid_argument("weight matrix must be numeric");
+    const double* w = converted.data();
+    py::gil_scoped_release release;
+    return program(w);
+}
+
+// Copies a per-instance / per-point result vector into a 1-D NumPy array
+static DoubleArray to_array(const std::vector<double>& v) {
+    DoubleArray out((py::ssize_t)v.size());
+    std::copy(v.begin(), v.end(), out.mutable_data());
+    return out;
+}
+
+// Binds one scalar instantiation of CrossbarArrayT; forward_batch takes and returns arrays of
+// that scalar type, so float32 batches reach CrossbarArrayF without a float64 round trip
+template <typename T>
+static void bind_crossbar(py::module_& m, const char* name) {
+    using Array = CrossbarArrayT<T>;
+    py::class_<Array>(m, name)
+        .def(py::init<int, int>(), py::arg("rows") = 8, py::arg("cols") = 8)
+        .def("rows", &Array::rows)
+        .def("cols", &Array::cols)
+        .def("reset", &Array::reset)
+        .def("set_inputs", &Array::set_inputs)
+        .def("inputs", &Array::inputs)
+        .def("outputs", &Array::outputs)
+        .def("differential_outputs", &Array::differential_outputs)
+        .def("w", &Array::w)
+        .def("r", &Array::r)
+        .def("i", &Array::i)
+        .def("power", &Array::power)
+        .def("dT", &Array::dT)
+        .def("calculate_current", &Array::calculate_current)
+        .def("params", &Array::params)
+        .def("set_params", &Array::set_params)
+        .def("enable_ir_drop", &Array::enable_ir_drop)
+        .def("set_enable_ir_drop", &Array::set_enable_ir_drop)
+        .def("r_wire", &Array::r_wire)
+        .def("set_r_wire", &Array::set_r_wire)
+        .def("solver_mode", &Array::solver_mode)
+        .def("set_solver_mode", &Array::set_solver_mode)
+        .def("v_row_node", &Array::v_row_node)
+        .def("v_col_node", &Array::v_col_node)
+        .def("enable_dac", &Array::enable_dac)
+        .def("set_enable_dac", &Array::set_enable_dac)
+        .def("dac_bits", &Array::dac_bits)
+        .def("set_dac_bits", &Array::set_dac_bits)
+        .def("enable_adc", &Array::enable_adc)
+        .def("set_enable_adc", &Array::set_enable_adc)
+        .def("adc_bits", &Array::adc_bits)
+        .def("set_adc_bits", &Array::set_adc_bits)
+        .def("update", &Array::update)
+        .def("forward_batch", [](Array& self, ScalarArray<T> X, double dt, bool read_only) {
+                 if (X.ndim() != 2 || X.shape(1) != self.rows()) {
+                     throw std::invalid_argument("forward_batch expects an array of shape (batch, rows)");
+                 }
+                 size_t batch = (size_t)X.shape(0);
+                 ScalarArray<T> Y({(py::ssize_t)batch, (py::ssize_t)self.cols()});
+                 const T* x = X.data();
+                 T* y = Y.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     self.forward_batch(x, batch, y, dt, read_only);
+                 }
+                 return Y;
+             },
+             py::arg("X"), py::arg("dt") = 0.001, py::arg("read_only") = false)
+        .def("program_cell", &Array::program_cell)
+        .def("program_cell_write_verify", &Array::program_cell_write_verify,
+             py::arg("row"), py::arg("col"), py::arg("w_val"), py::arg("tolerance") = 0.01, py::arg("max_pulses") = 30)
+        .def("program_matrix", [](Array& self, py::buffer W) {
+                 with_weight_matrix(self.rows(), self.cols(), W, [&](const auto* w) { self.program_matrix(w); });
+             },
+             py::arg("W"))
+        .def("program_matrix_write_verify", [](Array& self, py::buffer W, double tolerance, int max_pulses) {
+                 return with_weight_matrix(self.rows(), self.cols(), W, [&](const auto* w) {
+                     return self.program_matrix_write_verify(w, tolerance, max_pulses);
+                 });
+             },
+             py::arg("W"), py::arg("tolerance") = 0.01, py::arg("max_pulses") = 30)
+        .def("seed", &Array::seed)
+        .def("stats", &Array::stats)
+        .def("reset_stats", &Array::reset_stats);
+}
+
 PYBIND11_MODULE(memristorsim, m) {
     m.doc() = "Memristor 3D Simulator Python Bindings";
 
+    // Seed of the engines / arrays constructed afterwards without an explicit seed()
+    m.def("set_global_seed", &CounterRng::SetGlobalSeed, py::arg("seed"));
+
     // Bind ConductionModel
     py::enum_<ConductionModel>(m, "ConductionModel")
         .value("Sinh", ConductionModel::Sinh)
@@ -15,6 +136,28 @@ PYBIND11_MODULE(memristorsim, m) {
         .value("Schottky", ConductionModel::Schottky)
         .export_values();
 
+    // Bind IntegratorMode
+    py::enum_<IntegratorMode>(m, "IntegratorMode")
+        .value("RK4", IntegratorMode::RK4)
+        .value("BogackiShampine", IntegratorMode::BogackiShampine)
+        .value("DormandPrince", IntegratorMode::DormandPrince)
+        .export_values();
+
+    // Bind NodalSolverMode
+    py::enum_<NodalSolverMode>(m, "NodalSolverMode")
+        .value("GaussSeidel", NodalSolverMode::GaussSeidel)
+        .value("Newton", NodalSolverMode::Newton)
+        .export_values();
+
+    // Bind Waveform
+    py::enum_<Waveform>(m, "Waveform")
+        .value("DC", Waveform::DC)
+        .value("Sine", Waveform::Sine)
+        .value("Triangle", Waveform::Triangle)
+        .value("Pulse", Waveform::Pulse)
+        .value("RRAM_Sequence", Waveform::RRAM_Sequence)
+        .export_values();
+
     // Bind MemristorParams
     py::class_<MemristorParams>(m, "MemristorParams")
         .def(py::init<>())
@@ -42,6 +185,14 @@ PYBIND11_MODULE(memristorsim, m) {
         .def_readwrite("rtn_amplitude", &MemristorParams::rtn_amplitude)
         .def_readwrite("rtn_tau_c", &MemristorParams::rtn_tau_c)
         .def_readwrite("rtn_tau_e", &MemristorParams::rtn_tau_e)
+        .def_readwrite("subthreshold_c2c", &MemristorParams::subthreshold_c2c)
+        .def_readwrite("subthreshold_rtn", &MemristorParams::subthreshold_rtn)
+        .def_readwrite("enable_read_noise", &MemristorParams::enable_read_noise)
+        .def_readwrite("tabulated_current", &MemristorParams::tabulated_current)
+        .def_readwrite("table_v_max", &MemristorParams::table_v_max)
+        .def_readwrite("integrator", &MemristorParams::integrator)
+        .def_readwrite("integrator_rtol", &MemristorParams::integrator_rtol)
+        .def_readwrite("integrator_atol", &MemristorParams::integrator_atol)
         .def_readwrite("enable_selector", &MemristorParams::enable_selector)
         .def_readwrite("selector_type", &MemristorParams::selector_type)
         .def_readwrite("selector_v_th", &MemristorParams::selector_v_th)
@@ -53,12 +204,15 @@ PYBIND11_MODULE(memristorsim, m) {
     py::class_<PhysicsEngine>(m, "PhysicsEngine")
         .def(py::init<const MemristorParams&>())
         .def("reset", &PhysicsEngine::reset)
+        .def("seed", &PhysicsEngine::seed)
         .def("update", &PhysicsEngine::update)
         .def("w", &PhysicsEngine::w)
         .def("r", &PhysicsEngine::r)
         .def("i", &PhysicsEngine::i)
         .def("power", &PhysicsEngine::power)
         .def("dT", &PhysicsEngine::dT)
+        .def("last_substeps", &PhysicsEngine::last_substeps)
+        .def("integrator_failed", &PhysicsEngine::integrator_failed)
         .def("calculate_current", &PhysicsEngine::calculate_current)
         .def("calculate_memristor_current", &PhysicsEngine::calculate_memristor_current)
         .def("calculate_selector_current", &PhysicsEngine::calculate_selector_current)
@@ -68,37 +222,203 @@ PYBIND11_MODULE(memristorsim, m) {
         .def("program_write_verify", &PhysicsEngine::program_write_verify,
              py::arg("w_target"), py::arg("tolerance") = 0.01, py::arg("max_pulses") = 30);
 
-    // Bind CrossbarArray
-    py::class_<CrossbarArray>(m, "CrossbarArray")
+    // Bind the crossbar instrumentation counters (populated in MEMRISTORSIM_STATS builds only)
+    m.attr("stats_enabled") = kStatsEnabled;
+    m.def("stats_ticks_per_second", &StatsTicksPerSecond);
+    py::class_<KernelCounters>(m, "KernelCounters")
+        .def_readonly("current_calls", &KernelCounters::current_calls)
+        .def_readonly("selector_solves", &KernelCounters::selector_solves)
+        .def_readonly("selector_iterations", &KernelCounters::selector_iterations)
+        .def_readonly("selector_bisections", &KernelCounters::selector_bisections);
+    py::class_<CrossbarStats>(m, "CrossbarStats")
+        .def_readonly("updates", &CrossbarStats::updates)
+        .def_readonly("dac_ticks", &CrossbarStats::dac_ticks)
+        .def_readonly("solve_ticks", &CrossbarStats::solve_ticks)
+        .def_readonly("device_ticks", &CrossbarStats::device_ticks)
+        .def_readonly("adc_ticks", &CrossbarStats::adc_ticks)
+        .def_property_readonly("dac_seconds", [](const CrossbarStats& s) { return s.dac_ticks / StatsTicksPerSecond(); })
+        .def_property_readonly("solve_seconds", [](const CrossbarStats& s) { return s.solve_ticks / StatsTicksPerSecond(); })
+        .def_property_readonly("device_seconds", [](const CrossbarStats& s) { return s.device_ticks / StatsTicksPerSecond(); })
+        .def_property_readonly("adc_seconds", [](const CrossbarStats& s) { return s.adc_ticks / StatsTicksPerSecond(); })
+        .def_readonly("gs_solves", &CrossbarStats::gs_solves)
+        .def_readonly("gs_sweeps", &CrossbarStats::gs_sweeps)
+        .def_readonly("last_gs_sweeps", &CrossbarStats::last_gs_sweeps)
+        .def_readonly("last_gs_residual", &CrossbarStats::last_gs_residual)
+        .def_readonly("last_gs_converged", &CrossbarStats::last_gs_converged)
+        .def_readonly("newton_solves", &CrossbarStats::newton_solves)
+        .def_readonly("newton_iterations", &CrossbarStats::newton_iterations)
+        .def_readonly("newton_fallbacks", &CrossbarStats::newton_fallbacks)
+        .def_readonly("last_newton_iterations", &CrossbarStats::last_newton_iterations)
+        .def_readonly("last_newton_residual", &CrossbarStats::last_newton_residual)
+        .def_readonly("solve_kernel", &CrossbarStats::solve_kernel)
+        .def_readonly("device_kernel", &CrossbarStats::device_kernel);
+
+    // Bind CrossbarArray (float64 reference) and CrossbarArrayF (float32)
+    bind_crossbar<double>(m, "CrossbarArray");
+    bind_crossbar<float>(m, "CrossbarArrayF");
+
+    // Bind ThreadPool so several engines can run on one set of worker threads
+    py::class_<ThreadPool, std::shared_ptr<ThreadPool>>(m, "ThreadPool")
+        .def(py::init<size_t>(), py::arg("threads") = 0)
+        .def("size", &ThreadPool::size);
+
+    // Bind CrossbarPool
+    py::class_<CrossbarPool>(m, "CrossbarPool")
+        .def(py::init<const CrossbarArray&, size_t, uint64_t>(),
+             py::arg("prototype"), py::arg("workers") = 0, py::arg("seed") = 0x5EED)
+        .def(py::init<const CrossbarArray&, std::shared_ptr<ThreadPool>, uint64_t>(),
+             py::arg("prototype"), py::arg("pool"), py::arg("seed") = 0x5EED)
+        .def("workers", &CrossbarPool::workers)
+        .def("seed", &CrossbarPool::seed)
+        .def("set_seed", &CrossbarPool::set_seed)
+        .def("sync", &CrossbarPool::sync, py::call_guard<py::gil_scoped_release>())
+        .def("forward_batch", [](CrossbarPool& self, DoubleArray X, double dt, bool read_only) {
+                 const CrossbarArray& proto = self.prototype();
+                 if (X.ndim() != 2 || X.shape(1) != proto.rows()) {
+                     throw std::invalid_argument("forward_batch expects an array of shape (batch, rows)");
+                 }
+                 size_t batch = (size_t)X.shape(0);
+                 DoubleArray Y({(py::ssize_t)batch, (py::ssize_t)proto.cols()});
+                 const double* x = X.data();
+                 double* y = Y.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     self.forward_batch(x, batch, y, dt, read_only);
+                 }
+                 return Y;
+             },
+             py::arg("X"), py::arg("dt") = 0.001, py::arg("read_only") = false);
+
+    // Bind WaveformGenerator
+    py::class_<WaveformGenerator>(m, "WaveformGenerator")
+        .def(py::init<>())
+        .def("get_voltage", &WaveformGenerator::get_voltage)
+        .def("set_waveform", &WaveformGenerator::set_waveform)
+        .def("set_amplitude", &WaveformGenerator::set_amplitude)
+        .def("set_frequency", &WaveformGenerator::set_frequency)
+        .def("waveform", &WaveformGenerator::waveform)
+        .def("amplitude", &WaveformGenerator::amplitude)
+        .def("frequency", &WaveformGenerator::frequency);
+
+    // Bind TiledMatrix
+    py::class_<TiledMatrix>(m, "TiledMatrix")
+        .def(py::init<int, int, int, int, size_t>(),
+             py::arg("in_features"), py::arg("out_features"), py::arg("tile_rows") = 64, py::arg("tile_cols") = 64,
+             py::arg("workers") = 0)
+        .def(py::init<int, int, int, int, std::shared_ptr<ThreadPool>>(),
+             py::arg("in_features"), py::arg("out_features"), py::arg("tile_rows"), py::arg("tile_cols"), py::arg("pool"))
+        .def("in_features", &TiledMatrix::in_features)
+        .def("out_features", &TiledMatrix::out_features)
+        .def("tile_rows", &TiledMatrix::tile_rows)
+        .def("tile_cols", &TiledMatrix::tile_cols)
+        .def("grid_rows", &TiledMatrix::grid_rows)
+        .def("grid_cols", &TiledMatrix::grid_cols)
+        .def("tile_count", &TiledMatrix::tile_count)
+        .def("tile", py::overload_cast<int, int>(&TiledMatrix::tile), py::return_value_policy::reference_internal)
+        .def("set_params", &TiledMatrix::set_params)
+        .def("set_enable_ir_drop", &TiledMatrix::set_enable_ir_drop)
+        .def("set_r_wire", &TiledMatrix::set_r_wire)
+        .def("set_solver_mode", &TiledMatrix::set_solver_mode)
+        .def("set_enable_dac", &TiledMatrix::set_enable_dac)
+        .def("set_dac_bits", &TiledMatrix::set_dac_bits)
+        .def("set_enable_adc", &TiledMatrix::set_enable_adc)
+        .def("set_adc_bits", &TiledMatrix::set_adc_bits)
+        .def("set_adc_range", &TiledMatrix::set_adc_range)
+        .def("program_matrix", [](TiledMatrix& self, py::buffer W) {
+                 with_weight_matrix(self.in_features(), self.out_features(), W,
+                                    [&](const auto* w) { self.program_matrix(w); });
+             },
+             py::arg("W"))
+        .def("forward_batch", [](TiledMatrix& self, DoubleArray X, double dt, bool read_only) {
+                 if (X.ndim() != 2 || X.shape(1) != self.in_features()) {
+                     throw std::invalid_argument("forward_batch expects an array of shape (batch, in_features)");
+                 }
+                 size_t batch = (size_t)X.shape(0);
+                 DoubleArray Y({(py::ssize_t)batch, (py::ssize_t)self.out_features()});
+                 const double* x = X.data();
+                 double* y = Y.mutable_data();
+                 {
+                     py::gil_scoped_release release;
+                     self.forward_batch(x, batch, y, dt, read_only);
+                 }
+                 return Y;
+             },
+             py::arg("X"), py::arg("dt") = 0.001, py::arg("read_only") = false)
+        .def("tile_latency_ms", [](const TiledMatrix& self) {
+            // grid_rows x grid_cols wall-clock times of the last forward_batch
+            DoubleArray out({(py::ssize_t)self.grid_rows(), (py::ssize_t)self.grid_cols()});
+            std::copy(self.tile_latency_ms().begin(), self.tile_latency_ms().end(), out.mutable_data());
+            return out;
+        });
+
+    // Bind Monte Carlo ensembles
+    py::class_<EnsembleConfig>(m, "EnsembleConfig")
         .def(py::init<>())
-        .def("reset", &CrossbarArray::reset)
-        .def("set_inputs", &CrossbarArray::set_inputs)
-        .def("inputs", &CrossbarArray::inputs)
-        .def("outputs", &CrossbarArray::outputs)
-        .def("differential_outputs", &CrossbarArray::differential_outputs)
-        .def("w", &CrossbarArray::w)
-        .def("r", &CrossbarArray::r)
-        .def("i", &CrossbarArray::i)
-        .def("power", &CrossbarArray::power)
-        .def("dT", &CrossbarArray::dT)
-        .def("get_device", &CrossbarArray::get_device, py::return_value_policy::reference_internal)
-        .def("set_params", &CrossbarArray::set_params)
-        .def("enable_ir_drop", &CrossbarArray::enable_ir_drop)
-        .def("set_enable_ir_drop", &CrossbarArray::set_enable_ir_drop)
-        .def("r_wire", &CrossbarArray::r_wire)
-        .def("set_r_wire", &CrossbarArray::set_r_wire)
-        .def("v_row_node", &CrossbarArray::v_row_node)
-        .def("v_col_node", &CrossbarArray::v_col_node)
-        .def("enable_dac", &CrossbarArray::enable_dac)
-        .def("set_enable_dac", &CrossbarArray::set_enable_dac)
-        .def("dac_bits", &CrossbarArray::dac_bits)
-        .def("set_dac_bits", &CrossbarArray::set_dac_bits)
-        .def("enable_adc", &CrossbarArray::enable_adc)
-        .def("set_enable_adc", &CrossbarArray::set_enable_adc)
-        .def("adc_bits", &CrossbarArray::adc_bits)
-        .def("set_adc_bits", &CrossbarArray::set_adc_bits)
-        .def("update", &CrossbarArray::update)
-        .def("program_cell", &CrossbarArray::program_cell)
-        .def("program_cell_write_verify", &CrossbarArray::program_cell_write_verify,
-             py::arg("row"), py::arg("col"), py::arg("w_val"), py::arg("tolerance") = 0.01, py::arg("max_pulses") = 30);
+        .def_readwrite("instances", &EnsembleConfig::instances)
+        .def_readwrite("duration", &EnsembleConfig::duration)
+        .def_readwrite("dt", &EnsembleConfig::dt)
+        .def_readwrite("record_every", &EnsembleConfig::record_every)
+        .def_readwrite("switch_threshold", &EnsembleConfig::switch_threshold)
+        .def_readwrite("seed", &EnsembleConfig::seed);
+
+    py::class_<EnsembleSummary>(m, "EnsembleSummary")
+        .def_readonly("count", &EnsembleSummary::count)
+        .def_readonly("mean", &EnsembleSummary::mean)
+        .def_readonly("stddev", &EnsembleSummary::stddev)
+        .def_readonly("min", &EnsembleSummary::min)
+        .def_readonly("p05", &EnsembleSummary::p05)
+        .def_readonly("p50", &EnsembleSummary::p50)
+        .def_readonly("p95", &EnsembleSummary::p95)
+        .def_readonly("max", &EnsembleSummary::max);
+
+    py::class_<DeviceEnsembleResult>(m, "DeviceEnsembleResult")
+        .def_property_readonly("time", [](const DeviceEnsembleResult& r) { return to_array(r.time); })
+        .def_property_readonly("voltage", [](const DeviceEnsembleResult& r) { return to_array(r.voltage); })
+        .def_property_readonly("w_mean", [](const DeviceEnsembleResult& r) { return to_array(r.w_mean); })
+        .def_property_readonly("w_std", [](const DeviceEnsembleResult& r) { return to_array(r.w_std); })
+        .def_property_readonly("w_p05", [](const DeviceEnsembleResult& r) { return to_array(r.w_p05); })
+        .def_property_readonly("w_p50", [](const DeviceEnsembleResult& r) { return to_array(r.w_p50); })
+        .def_property_readonly("w_p95", [](const DeviceEnsembleResult& r) { return to_array(r.w_p95); })
+        .def_property_readonly("i_mean", [](const DeviceEnsembleResult& r) { return to_array(r.i_mean); })
+        .def_property_readonly("i_std", [](const DeviceEnsembleResult& r) { return to_array(r.i_std); })
+        .def_property_readonly("final_w", [](const DeviceEnsembleResult& r) { return to_array(r.final_w); })
+        .def_property_readonly("v_set", [](const DeviceEnsembleResult& r) { return to_array(r.v_set); })
+        .def_property_readonly("v_reset", [](const DeviceEnsembleResult& r) { return to_array(r.v_reset); })
+        .def_readonly("final_w_stats", &DeviceEnsembleResult::final_w_stats)
+        .def_readonly("v_set_stats", &DeviceEnsembleResult::v_set_stats)
+        .def_readonly("v_reset_stats", &DeviceEnsembleResult::v_reset_stats)
+        .def_readonly("set_yield", &DeviceEnsembleResult::set_yield)
+        .def_readonly("reset_yield", &DeviceEnsembleResult::reset_yield);
+
+    py::class_<CrossbarEnsembleResult>(m, "CrossbarEnsembleResult")
+        .def_property_readonly("final_outputs", [](const CrossbarEnsembleResult& r) {
+            // instances x cols
+            DoubleArray out({(py::ssize_t)(r.cols ? r.final_outputs.size() / r.cols : 0), (py::ssize_t)r.cols});
+            std::copy(r.final_outputs.begin(), r.final_outputs.end(), out.mutable_data());
+            return out;
+        })
+        .def_readonly("column_stats", &CrossbarEnsembleResult::column_stats);
+
+    py::class_<MonteCarloEnsemble>(m, "MonteCarloEnsemble")
+        .def(py::init<size_t>(), py::arg("workers") = 0)
+        .def("workers", &MonteCarloEnsemble::workers)
+        .def("run_devices", &MonteCarloEnsemble::run_devices,
+             py::arg("params"), py::arg("waveform"), py::arg("config"), py::call_guard<py::gil_scoped_release>())
+        .def("run_crossbars", [](MonteCarloEnsemble& self, const CrossbarArray& prototype, py::object W,
+                                 const WaveformGenerator& waveform, const EnsembleConfig& config) {
+                 if (W.is_none()) {
+                     py::gil_scoped_release release;
+                     return self.run_crossbars(prototype, nullptr, waveform, config);
+                 }
+                 DoubleArray weights = DoubleArray::ensure(W);
+                 if (!weights || weights.ndim() != 2 || weights.shape(0) != prototype.rows() ||
+                     weights.shape(1) != prototype.cols()) {
+                     throw std::invalid_argument("weight matrix must have shape (rows, cols)");
+                 }
+                 const double* w = weights.data();
+                 py::gil_scoped_release release;
+                 return self.run_crossbars(prototype, w, waveform, config);
+             },
+             py::arg("prototype"), py::arg("W"), py::arg("waveform"), py::arg("config"))
+        .def_static("summarize", &MonteCarloEnsemble::Summarize);
 }
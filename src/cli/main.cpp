@@ -0,0 +1,414 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "physics/Memristor.h"
+#include "physics/Crossbar.h"
+#include "physics/Optimizer.h"
+#include "physics/BatchFitter.h"
+#include "utils/Waveform.h"
+#include "utils/ConfigManager.h"
+#include "utils/TraceFile.h"
+
+// Headless runner for build servers: steps the physics at full CPU speed (no render loop)
+// and writes the results to a file. See print_usage() for the jobs and their options.
+
+static void print_usage() {
+    std::cerr << "Usage: memristor_cli <device|crossbar|fit|batch-fit|convert> [options] --out FILE\n"
+                 "\n"
+                 "  device    integrate one device under a waveform, write t,V,I,w,R,dT rows\n"
+                 "            --waveform dc|sine|triangle|pulse|rram  --amplitude V  --frequency Hz\n"
+                 "            --duration s  --dt s  --decimate N\n"
+                 "  crossbar  run an N x M array for a number of steps, write the bitline currents\n"
+                 "            --rows N  --cols M  --weights random|identity|VALUE\n"
+                 "            --steps N  --dt s  --input V  --waveform NAME  --read-only\n"
+                 "            --ir-drop  --r-wire Ohm  --solver gs|newton  --dac-bits N  --adc-bits N\n"
+                 "  fit       fit device parameters to a measured I-V CSV, write a config JSON\n"
+                 "            --csv FILE  --method nm|de|lm  --fit r,k,alpha,v,beta  --workers N\n"
+                 "            --coarse-levels N  --no-early-abort  --parse-threads N  --cache\n"
+                 "  batch-fit fit every CSV of a directory or manifest on all cores, write one table\n"
+                 "            --dir DIR | --manifest FILE  --workers N  --no-resume  --cache  (+ fit options)\n"
+                 "  convert   parse a measured I-V CSV once, write it as a binary trace cache that\n"
+                 "            fit / batch-fit load directly  --csv FILE  --parse-threads N\n"
+                 "\n"
+                 "  --cache   read each CSV from FILE.mtrace when that is current, and write it otherwise\n"
+                 "\n"
+                 "  common    --config FILE  --preset NAME  --integrator rk4|bs|dp  --rtol TOL\n"
+                 "            --variability  --rtn  --seed S (noise streams; also the random weights)\n";
+}
+
+// --key value / --flag pairs after the job name
+class Args {
+public:
+    Args(int argc, char** argv, int first) {
+        for (int i = first; i < argc; ++i) {
+            std::string key = argv[i];
+            if (key.rfind("--", 0) != 0) {
+                m_errors.push_back("unexpected argument '" + key + "'");
+                continue;
+            }
+            key = key.substr(2);
+            if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                m_values[key] = argv[++i];
+            } else {
+                m_values[key] = "";
+            }
+        }
+    }
+
+    bool has(const std::string& key) const { return m_values.count(key) > 0; }
+    std::string str(const std::string& key, const std::string& def = "") const {
+        auto it = m_values.find(key);
+        return it == m_values.end() ? def : it->second;
+    }
+    double num(const std::string& key, double def) const {
+        auto it = m_values.find(key);
+        if (it == m_values.end() || it->second.empty()) return def;
+        char* end = nullptr;
+        double v = std::strtod(it->second.c_str(), &end);
+        return (end && *end == '\0') ? v : def;
+    }
+    const std::vector<std::string>& errors() const { return m_errors; }
+
+private:
+    std::map<std::string, std::string> m_values;
+    std::vector<std::string> m_errors;
+};
+
+static bool parse_waveform(const std::string& name, Waveform& w) {
+    static const std::map<std::string, Waveform> names = {
+        {"dc", Waveform::DC}, {"sine", Waveform::Sine}, {"triangle", Waveform::Triangle},
+        {"pulse", Waveform::Pulse}, {"rram", Waveform::RRAM_Sequence}};
+    auto it = names.find(name);
+    if (it == names.end()) return false;
+    w = it->second;
+    return true;
+}
+
+static bool parse_integrator(const std::string& name, IntegratorMode& mode) {
+    if (name == "rk4") mode = IntegratorMode::RK4;
+    else if (name == "bs") mode = IntegratorMode::BogackiShampine;
+    else if (name == "dp") mode = IntegratorMode::DormandPrince;
+    else return false;
+    return true;
+}
+
+// Device parameters and waveform from --preset / --config / individual flags (in that order)
+static bool load_setup(const Args& args, MemristorParams& params, WaveformGenerator& waveform) {
+    if (args.has("preset")) {
+        auto presets = MemristorLibrary::GetPresets();
+        auto it = presets.find(args.str("preset"));
+        if (it == presets.end()) {
+            std::cerr << "Unknown preset '" << args.str("preset") << "'. Available:";
+            for (const auto& kv : presets) std::cerr << " \"" << kv.first << "\"";
+            std::cerr << "\n";
+            return false;
+        }
+        params = it->second;
+    }
+    if (args.has("config")) {
+        int wave_type = (int)waveform.waveform();
+        if (!ConfigManager::Load(args.str("config"), params, waveform.pulse_settings(), wave_type)) {
+            std::cerr << "Could not open config file: " << args.str("config") << "\n";
+            return false;
+        }
+        waveform.set_waveform((Waveform)wave_type);
+    }
+    if (args.has("waveform")) {
+        Waveform w;
+        if (!parse_waveform(args.str("waveform"), w)) {
+            std::cerr << "Unknown waveform '" << args.str("waveform") << "' (dc, sine, triangle, pulse, rram)\n";
+            return false;
+        }
+        waveform.set_waveform(w);
+    }
+    waveform.set_amplitude(args.num("amplitude", waveform.amplitude()));
+    waveform.set_frequency(args.num("frequency", waveform.frequency()));
+    if (args.has("integrator") && !parse_integrator(args.str("integrator"), params.integrator)) {
+        std::cerr << "Unknown integrator '" << args.str("integrator") << "' (rk4, bs, dp)\n";
+        return false;
+    }
+    params.integrator_rtol = args.num("rtol", params.integrator_rtol);
+    params.enable_variability = args.has("variability") || params.enable_variability;
+    params.enable_rtn = args.has("rtn") || params.enable_rtn;
+    return true;
+}
+
+static int run_device(const Args& args, std::ofstream& out) {
+    MemristorParams params;
+    WaveformGenerator waveform;
+    waveform.set_waveform(Waveform::Sine);
+    waveform.set_amplitude(1.5);
+    if (!load_setup(args, params, waveform)) return 1;
+
+    double dt = args.num("dt", 1e-4);
+    double duration = args.num("duration", 2.0);
+    long long decimate = std::max(1LL, (long long)args.num("decimate", 1));
+    if (dt <= 0.0 || duration <= 0.0) {
+        std::cerr << "--dt and --duration must be positive\n";
+        return 1;
+    }
+
+    PhysicsEngine physics(params);
+    long long steps = (long long)(duration / dt);
+    long long substeps = 0;
+    out << "Time,Voltage,Current,State,Resistance,TempRise\n";
+    auto start = std::chrono::steady_clock::now();
+    for (long long s = 1; s <= steps; ++s) {
+        double t = s * dt;
+        double v = waveform.get_voltage(t);
+        physics.update(dt, v);
+        substeps += physics.last_substeps();
+        if (s % decimate == 0) {
+            out << t << "," << v << "," << physics.i() << "," << physics.w() << ","
+                << physics.r() << "," << physics.dT() << "\n";
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "device: " << steps << " steps (" << substeps << " RK substeps) in " << secs << " s ("
+              << (secs > 0.0 ? steps / secs : 0.0) << " steps/s)\n";
+    return 0;
+}
+
+static int run_crossbar(const Args& args, std::ofstream& out) {
+    MemristorParams params;
+    WaveformGenerator waveform;
+    waveform.set_waveform(Waveform::DC);
+    waveform.set_amplitude(args.num("input", 0.2));
+    int rows = (int)args.num("rows", 8);
+    int cols = (int)args.num("cols", 8);
+    CrossbarArray xbar(rows, cols);
+    params = xbar.params();
+    if (!load_setup(args, params, waveform)) return 1;
+    xbar.set_params(params);
+    xbar.reset();
+
+    xbar.set_enable_ir_drop(args.has("ir-drop"));
+    xbar.set_r_wire(args.num("r-wire", xbar.r_wire()));
+    std::string solver = args.str("solver", "gs");
+    if (solver == "newton") xbar.set_solver_mode(NodalSolverMode::Newton);
+    else if (solver != "gs") {
+        std::cerr << "Unknown solver '" << solver << "' (gs, newton)\n";
+        return 1;
+    }
+    if (args.has("dac-bits")) {
+        xbar.set_enable_dac(true);
+        xbar.set_dac_bits((int)args.num("dac-bits", 8));
+    }
+    if (args.has("adc-bits")) {
+        xbar.set_enable_adc(true);
+        xbar.set_adc_bits((int)args.num("adc-bits", 8));
+    }
+
+    // Weight programming: random conductances, identity, or one uniform value
+    std::string weights = args.str("weights", "random");
+    std::vector<double> w((size_t)xbar.rows() * xbar.cols(), 0.0);
+    if (weights == "random") {
+        std::mt19937 rng((unsigned)args.num("seed", 42));
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        for (double& x : w) x = dist(rng);
+    } else if (weights == "identity") {
+        for (int i = 0; i < std::min(xbar.rows(), xbar.cols()); ++i) w[(size_t)i * xbar.cols() + i] = 1.0;
+    } else {
+        std::fill(w.begin(), w.end(), args.num("weights", 0.5));
+    }
+    xbar.program_matrix(w.data());
+
+    double dt = args.num("dt", 1e-3);
+    long long steps = std::max(1LL, (long long)args.num("steps", 1000));
+    bool read_only = args.has("read-only");
+
+    out << "Step,Time,Input";
+    for (int j = 0; j < xbar.cols(); ++j) out << ",I_" << j;
+    out << "\n";
+
+    std::vector<double> x((size_t)xbar.rows());
+    std::vector<double> y((size_t)xbar.cols());
+    auto start = std::chrono::steady_clock::now();
+    for (long long s = 1; s <= steps; ++s) {
+        double t = s * dt;
+        double v = waveform.get_voltage(t);
+        std::fill(x.begin(), x.end(), v);
+        xbar.forward_batch(x.data(), 1, y.data(), dt, read_only);
+        out << s << "," << t << "," << v;
+        for (double i : y) out << "," << i;
+        out << "\n";
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "crossbar " << xbar.rows() << "x" << xbar.cols() << ": " << steps << " steps in " << secs
+              << " s (" << (secs > 0.0 ? steps / secs : 0.0) << " steps/s)\n";
+    return 0;
+}
+
+// --method / --fit / --workers / --coarse-levels / --no-early-abort, shared by fit and batch-fit
+static bool parse_fit_options(const Args& args, FitOptions& options) {
+    std::string method = args.str("method", "nm");
+    if (method == "de") options.method = FitMethod::DifferentialEvolution;
+    else if (method == "lm") options.method = FitMethod::LevenbergMarquardt;
+    else if (method != "nm") {
+        std::cerr << "Unknown method '" << method << "' (nm, de, lm)\n";
+        return false;
+    }
+    if (args.has("fit")) {
+        static const std::map<std::string, unsigned> groups = {
+            {"r", FitResistance}, {"k", FitRates}, {"alpha", FitAlpha}, {"v", FitThresholds}, {"beta", FitConduction}};
+        options.parameters = 0;
+        std::stringstream list(args.str("fit"));
+        std::string name;
+        while (std::getline(list, name, ',')) {
+            auto it = groups.find(name);
+            if (it == groups.end()) {
+                std::cerr << "Unknown parameter group '" << name << "' (r, k, alpha, v, beta)\n";
+                return false;
+            }
+            options.parameters |= it->second;
+        }
+    }
+    options.de.workers = (size_t)args.num("workers", 0);
+    options.coarse_levels = (int)args.num("coarse-levels", options.coarse_levels);
+    options.early_abort = !args.has("no-early-abort");
+    return true;
+}
+
+// --parse-threads N (0 = all cores) and --cache for the measured-trace loaders
+static TraceLoadOptions load_options(const Args& args) {
+    TraceLoadOptions options;
+    options.threads = (size_t)args.num("parse-threads", 1);
+    options.use_cache = args.has("cache");
+    return options;
+}
+
+static int run_fit(const Args& args, const std::string& out_path) {
+    MemristorParams params;
+    WaveformGenerator waveform;
+    if (!load_setup(args, params, waveform)) return 1;
+    if (!args.has("csv")) {
+        std::cerr << "fit requires --csv FILE\n";
+        return 1;
+    }
+
+    FitOptions options;
+    if (!parse_fit_options(args, options)) return 1;
+
+    std::string err;
+    auto dataset = MemristorFitter::LoadCSV(args.str("csv"), err, load_options(args));
+    if (!err.empty()) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+
+    double mse = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    MemristorParams fitted = MemristorFitter::Fit(dataset, params, mse, options);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ConfigManager::Save(out_path, fitted, waveform.pulse_settings(), (int)waveform.waveform());
+    std::cerr << "fit: " << dataset.size() << " points in " << secs << " s, MSE " << mse << " (";
+    auto vars = MemristorFitter::Variables(options.parameters, fitted.conduction_model);
+    for (size_t k = 0; k < vars.size(); ++k) std::cerr << (k ? ", " : "") << vars[k].name << " " << fitted.*vars[k].field;
+    std::cerr << ")\n";
+    return 0;
+}
+
+static int run_batch_fit(const Args& args, const std::string& out_path) {
+    MemristorParams params;
+    WaveformGenerator waveform;
+    if (!load_setup(args, params, waveform)) return 1;
+    FitOptions options;
+    if (!parse_fit_options(args, options)) return 1;
+
+    std::string err;
+    std::vector<std::string> files;
+    if (args.has("manifest")) files = BatchFitter::ReadManifest(args.str("manifest"), err);
+    else if (args.has("dir")) files = BatchFitter::ListDirectory(args.str("dir"), err);
+    else err = "batch-fit requires --dir DIR or --manifest FILE";
+    if (!err.empty()) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+
+    BatchFitter fitter((size_t)args.num("workers", 0));
+    TraceLoadOptions load;
+    load.use_cache = args.has("cache");
+    fitter.set_load_options(load);
+    size_t failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto results = fitter.run(files, params, options, out_path, err, !args.has("no-resume"),
+                              [&](const BatchFitResult& r, size_t done, size_t total) {
+                                  if (!r.ok) ++failed;
+                                  std::cerr << "[" << done << "/" << total << "] " << r.device << ": ";
+                                  if (r.ok) std::cerr << "MSE " << r.mse << " (" << r.seconds << " s)\n";
+                                  else std::cerr << r.error << "\n";
+                              });
+    if (!err.empty()) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "batch-fit: " << results.size() << " of " << results.size() + fitter.skipped()
+              << " devices fitted in " << secs << " s on " << fitter.workers() << " workers (" << failed
+              << " failed, " << fitter.skipped() << " skipped as already in the table)\n";
+    return failed ? 2 : 0;
+}
+
+static int run_convert(const Args& args, const std::string& out_path) {
+    if (!args.has("csv")) {
+        std::cerr << "convert requires --csv FILE\n";
+        return 1;
+    }
+    std::string err;
+    TraceColumns trace;
+    auto start = std::chrono::steady_clock::now();
+    if (!TraceFile::Load(args.str("csv"), trace, err, load_options(args)) || !TraceFile::SaveBinary(out_path, trace, err)) {
+        std::cerr << err << "\n";
+        return 1;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "convert: " << trace.size() << " rows in " << secs << " s\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h") {
+        print_usage();
+        return argc < 2 ? 1 : 0;
+    }
+    std::string job = argv[1];
+    if (job != "device" && job != "crossbar" && job != "fit" && job != "batch-fit" && job != "convert") {
+        std::cerr << "Unknown job '" << job << "'\n";
+        print_usage();
+        return 1;
+    }
+    Args args(argc, argv, 2);
+    for (const auto& e : args.errors()) std::cerr << e << "\n";
+    if (!args.errors().empty()) return 1;
+    if (args.has("help")) {
+        print_usage();
+        return 0;
+    }
+    if (!args.has("out") || args.str("out").empty()) {
+        std::cerr << "--out FILE is required\n";
+        return 1;
+    }
+    std::string out_path = args.str("out");
+    if (args.has("seed")) CounterRng::SetGlobalSeed((uint64_t)args.num("seed", 0));
+
+    if (job == "fit") return run_fit(args, out_path);
+    if (job == "batch-fit") return run_batch_fit(args, out_path);
+    if (job == "convert") return run_convert(args, out_path);
+
+    std::ofstream out(out_path);
+    if (!out.is_open()) {
+        std::cerr << "Could not open output file: " << out_path << "\n";
+        return 1;
+    }
+    out.precision(10);
+    if (job == "device") return run_device(args, out);
+    return run_crossbar(args, out);
+}
@@ -2,7 +2,7 @@
 #include <imgui.h>
 #include <implot.h>
 #include <glad/glad.h>
-#include <fstream>
+#include <random>
 #include <vector>
 #include "../utils/ConfigManager.h"
 #include <backends/imgui_impl_glfw.h>
@@ -106,7 +106,8 @@ static Waveform index_to_waveform(int idx) {
     return Waveform::DC;
 }
 
-void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, PhysicsEngine& physics) {
+void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, PhysicsEngine& physics,
+                        const SimulationSnapshot& state) {
     ImGui::Begin("Controls");
     
     // Switch Mode Button
@@ -132,11 +133,11 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
             }
             ImGui::Spacing();
             
-            float cellSize = ImGui::GetContentRegionAvail().x / 8.5f;
+            float cellSize = ImGui::GetContentRegionAvail().x / (m_crossbar.cols() + 0.5f);
             if (cellSize < 20.0f) cellSize = 20.0f;
             
-            for (int r = 0; r < 8; ++r) {
-                for (int c = 0; c < 8; ++c) {
+            for (int r = 0; r < m_crossbar.rows(); ++r) {
+                for (int c = 0; c < m_crossbar.cols(); ++c) {
                     double w_val = m_crossbar.w(r, c);
                     ImVec4 cell_col;
                     if (m_show_sneak_paths) {
@@ -184,7 +185,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                     }
                     
                     ImGui::PopStyleColor(3);
-                    if (c < 7) ImGui::SameLine();
+                    if (c < m_crossbar.cols() - 1) ImGui::SameLine();
                 }
             }
             
@@ -199,14 +200,14 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
             // Synapse preset buttons
             ImGui::Text("Synaptic Programming Preset Kernels:");
             if (ImGui::Button("Clear Array (All OFF)", ImVec2(ImGui::GetContentRegionAvail().x * 0.48f, 24.0f))) {
-                for (int r = 0; r < 8; ++r) {
-                    for (int c = 0; c < 8; ++c) m_crossbar.program_cell(r, c, 0.0);
+                for (int r = 0; r < m_crossbar.rows(); ++r) {
+                    for (int c = 0; c < m_crossbar.cols(); ++c) m_crossbar.program_cell(r, c, 0.0);
                 }
             }
             ImGui::SameLine();
             if (ImGui::Button("Set Synapse Diagonal", ImVec2(ImGui::GetContentRegionAvail().x * 0.96f, 24.0f))) {
-                for (int r = 0; r < 8; ++r) {
-                    for (int c = 0; c < 8; ++c) {
+                for (int r = 0; r < m_crossbar.rows(); ++r) {
+                    for (int c = 0; c < m_crossbar.cols(); ++c) {
                         m_crossbar.program_cell(r, c, r == c ? 1.0 : 0.0);
                     }
                 }
@@ -214,8 +215,8 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
             if (ImGui::Button("Randomize Synaptic Weights", ImVec2(-1.0f, 24.0f))) {
                 std::default_random_engine rng(std::random_device{}());
                 std::uniform_real_distribution<double> dist(0.0, 1.0);
-                for (int r = 0; r < 8; ++r) {
-                    for (int c = 0; c < 8; ++c) m_crossbar.program_cell(r, c, dist(rng));
+                for (int r = 0; r < m_crossbar.rows(); ++r) {
+                    for (int c = 0; c < m_crossbar.cols(); ++c) m_crossbar.program_cell(r, c, dist(rng));
                 }
             }
         }
@@ -230,6 +231,11 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                 if (ImGui::SliderFloat("Wire Resistance (r_wire)", &r_w, 0.1f, 10.0f, "%.2f Ohm")) {
                     m_crossbar.set_r_wire(r_w);
                 }
+                int solver_idx = (int)m_crossbar.solver_mode();
+                const char* solvers[] = { "Gauss-Seidel Relaxation", "Newton-Raphson (Sparse Cholesky)" };
+                if (ImGui::Combo("Nodal Solver", &solver_idx, solvers, 2)) {
+                    m_crossbar.set_solver_mode((NodalSolverMode)solver_idx);
+                }
                 ImGui::TextWrapped("Iterative Nodal Analysis computes row/column voltage drops along the metal lines.");
             }
             
@@ -267,7 +273,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
             ImGui::Columns(2, "WL_Inputs", false);
             ImGui::SetColumnWidth(0, ImGui::GetWindowWidth() * 0.5f);
             
-            for (int i = 0; i < 8; ++i) {
+            for (int i = 0; i < m_crossbar.rows(); ++i) {
                 char wlId[32];
                 sprintf(wlId, "V_WL[%d]", i);
                 float val = (float)current_inputs[i];
@@ -284,7 +290,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
             const std::vector<double>& current_outputs = m_crossbar.outputs();
             
             ImGui::Columns(4, "BL_Outputs", false);
-            for (int j = 0; j < 8; ++j) {
+            for (int j = 0; j < m_crossbar.cols(); ++j) {
                 ImGui::Text("I_BL[%d]:", j); ImGui::NextColumn();
                 ImGui::TextColored(ImVec4(0.0f, 0.9f, 0.4f, 1.0f), "%.4f A", current_outputs[j]); ImGui::NextColumn();
             }
@@ -345,8 +351,8 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                 }
                 
                 // Visually program the weights into the crossbar heatmap
-                for (int r = 0; r < 8; ++r) {
-                    for (int c = 0; c < 8; ++c) {
+                for (int r = 0; r < m_crossbar.rows(); ++r) {
+                    for (int c = 0; c < m_crossbar.cols(); ++c) {
                         if (c < 3 && r < 3) {
                             double mapped_w = (selected_k[r][c] + 2.0) / 4.0;
                             m_crossbar.program_cell(r, c, mapped_w);
@@ -471,6 +477,19 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                 params.conduction_model = (ConductionModel)model_idx;
             }
             
+            int integrator_idx = (int)params.integrator;
+            const char* integrators[] = { "RK4 (fixed step)", "Bogacki-Shampine 3(2)", "Dormand-Prince 5(4)" };
+            if (ImGui::Combo("Integrator", &integrator_idx, integrators, 3)) {
+                params.integrator = (IntegratorMode)integrator_idx;
+            }
+            if (params.integrator != IntegratorMode::RK4) {
+                float rtol_log_f = (float)std::log10(params.integrator_rtol);
+                if (ImGui::SliderFloat("Tolerance (log10 rtol)", &rtol_log_f, -10.0f, -2.0f, "%.1f")) {
+                    params.integrator_rtol = std::pow(10.0, (double)rtol_log_f);
+                    params.integrator_atol = params.integrator_rtol * 1e-3;
+                }
+            }
+            
             if (params.conduction_model == ConductionModel::Sinh) {
                 float gamma_sinh_f = (float)params.gamma_sinh;
                 if (ImGui::SliderFloat("Sinh Factor (gamma)", &gamma_sinh_f, 0.5f, 5.0f, "%.2f")) {
@@ -489,6 +508,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                 }
                 ImGui::TextWrapped("Schottky Tunneling: ln(I) is proportional to sqrt(V). Mapped to R_off at 1V.");
             }
+            ImGui::Checkbox("Tabulated I(V, w) (fast reads)", &params.tabulated_current);
             
             ImGui::Separator();
             ImGui::Checkbox("Enable Series Selector (1S1R / 1T1R)", &params.enable_selector);
@@ -528,6 +548,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                 if (ImGui::SliderFloat("C2C write noise (SDE)", &sigma_c2c_f, 0.005f, 0.1f, "%.3f")) {
                     params.sigma_c2c = (double)sigma_c2c_f;
                 }
+                ImGui::Checkbox("C2C noise on sub-threshold reads", &params.subthreshold_c2c);
                 ImGui::TextWrapped("Variability applies normal/log-normal scatter to device properties upon reset/creation.");
             }
             
@@ -546,36 +567,43 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
                 if (ImGui::SliderFloat("Emission lifetime (tau_e)", &rtn_tau_e_f, 0.005f, 0.5f, "%.3f s")) {
                     params.rtn_tau_e = (double)rtn_tau_e_f;
                 }
+                ImGui::Checkbox("RTN switching on sub-threshold reads", &params.subthreshold_rtn);
                 ImGui::TextWrapped("RTN models discrete capture/emission events, visible as telegraph jumps on the I-V plot.");
             }
+
+            ImGui::Separator();
+            ImGui::Checkbox("Read noise (5% SD)", &params.enable_read_noise);
         }
-        
+
         if (ImGui::CollapsingHeader("Real-Time Telemetry", ImGuiTreeNodeFlags_DefaultOpen)) {
-            ImGui::Text("Filament State (w): %.3f", physics.w());
-            ImGui::ProgressBar((float)physics.w(), ImVec2(-1.0f, 16.0f), "");
+            ImGui::Text("Filament State (w): %.3f", state.w);
+            ImGui::ProgressBar((float)state.w, ImVec2(-1.0f, 16.0f), "");
             
             ImGui::Columns(2, "TelemetryColumns", false);
             ImGui::SetColumnWidth(0, 120.0f);
             
             ImGui::Text("Resistance (R):"); ImGui::NextColumn();
-            ImGui::TextColored(ImVec4(0.2f, 0.8f, 1.0f, 1.0f), "%.1f Ohms", physics.r()); ImGui::NextColumn();
+            ImGui::TextColored(ImVec4(0.2f, 0.8f, 1.0f, 1.0f), "%.1f Ohms", state.r); ImGui::NextColumn();
             
             ImGui::Text("Current (I):"); ImGui::NextColumn();
-            ImGui::TextColored(ImVec4(0.0f, 0.9f, 0.4f, 1.0f), "%.6f A", physics.i()); ImGui::NextColumn();
+            ImGui::TextColored(ImVec4(0.0f, 0.9f, 0.4f, 1.0f), "%.6f A", state.i); ImGui::NextColumn();
             
             ImGui::Text("Power (P):"); ImGui::NextColumn();
-            ImGui::TextColored(ImVec4(0.9f, 0.8f, 0.1f, 1.0f), "%.6f W", physics.power()); ImGui::NextColumn();
+            ImGui::TextColored(ImVec4(0.9f, 0.8f, 0.1f, 1.0f), "%.6f W", state.power); ImGui::NextColumn();
             
             ImGui::Text("Temp Rise (dT):"); ImGui::NextColumn();
-            double temp = physics.dT();
+            double temp = state.dT;
             ImVec4 temp_color = ImVec4(0.2f, 0.9f, 0.4f, 1.0f);
             if (temp > params.T_critical) temp_color = ImVec4(1.0f, 0.1f, 0.1f, 1.0f);
             else if (temp > params.T_critical * 0.7) temp_color = ImVec4(1.0f, 0.6f, 0.0f, 1.0f);
             ImGui::TextColored(temp_color, "%.1f K / %.1f K", temp, params.T_critical); ImGui::NextColumn();
             
+            ImGui::Text("RK Substeps:"); ImGui::NextColumn();
+            ImGui::Text("%d", state.substeps); ImGui::NextColumn();
+            
             ImGui::Columns(1);
             
-            double current_mag = std::fabs(physics.i());
+            double current_mag = std::fabs(state.i);
             bool is_compliant = (current_mag >= params.I_compliance * 0.99);
             bool is_thermal_decay = (temp > params.T_critical);
             
@@ -606,7 +634,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
     // -------------------------------------------------------------
     ImGui::Begin("Parameter Auto-Fitting");
     
-    ImGui::TextWrapped("Import experimental measurement data to extract model parameters (R_on, R_off, k_on, k_off) using a Nelder-Mead simplex optimizer.");
+    ImGui::TextWrapped("Import experimental measurement data to extract model parameters using a Nelder-Mead simplex or a parallel differential-evolution optimizer.");
     ImGui::Separator();
     
     static char filepath_buf[256] = "experimental_data.csv";
@@ -634,13 +662,25 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
         ImGui::EndPopup();
     }
     
+    static FitOptions fit_options;
+    int fit_method = (int)fit_options.method;
+    const char* fit_methods[] = { "Nelder-Mead (local)", "Differential Evolution (parallel)", "Levenberg-Marquardt (gradient)" };
+    if (ImGui::Combo("Optimizer", &fit_method, fit_methods, IM_ARRAYSIZE(fit_methods))) {
+        fit_options.method = (FitMethod)fit_method;
+    }
+    ImGui::CheckboxFlags("R_on / R_off", &fit_options.parameters, FitResistance); ImGui::SameLine();
+    ImGui::CheckboxFlags("k_on / k_off", &fit_options.parameters, FitRates);
+    ImGui::CheckboxFlags("alpha_on / alpha_off", &fit_options.parameters, FitAlpha); ImGui::SameLine();
+    ImGui::CheckboxFlags("v_on / v_off", &fit_options.parameters, FitThresholds);
+    ImGui::CheckboxFlags("Conduction beta", &fit_options.parameters, FitConduction);
+
     static std::string status_msg = "Idle";
     static std::string err_msg = "";
     static double fit_mse = 0.0;
     static MemristorParams fitted_results;
     static bool fit_completed = false;
     
-    if (ImGui::Button("Run Nelder-Mead Optimization", ImVec2(-1.0f, 30.0f))) {
+    if (ImGui::Button("Run Optimization", ImVec2(-1.0f, 30.0f))) {
         status_msg = "Running...";
         err_msg = "";
         std::string err;
@@ -650,7 +690,7 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
             status_msg = "Failed";
         } else {
             double mse = 0.0;
-            fitted_results = MemristorFitter::Fit(dataset, params, mse);
+            fitted_results = MemristorFitter::Fit(dataset, params, mse, fit_options);
             fit_mse = mse;
             status_msg = "Completed Successfully";
             fit_completed = true;
@@ -687,17 +727,10 @@ void Gui::draw_controls(MemristorParams& params, WaveformGenerator& waveform, Ph
         ImGui::Text("Fitted Value"); ImGui::NextColumn();
         ImGui::Separator();
         
-        ImGui::Text("R_on"); ImGui::NextColumn();
-        ImGui::Text("%.2f Ohm", fitted_results.R_on); ImGui::NextColumn();
-        
-        ImGui::Text("R_off"); ImGui::NextColumn();
-        ImGui::Text("%.2f Ohm", fitted_results.R_off); ImGui::NextColumn();
-        
-        ImGui::Text("k_on"); ImGui::NextColumn();
-        ImGui::Text("%.2f", fitted_results.k_on); ImGui::NextColumn();
-        
-        ImGui::Text("k_off"); ImGui::NextColumn();
-        ImGui::Text("%.2f", fitted_results.k_off); ImGui::NextColumn();
+        for (const auto& v : MemristorFitter::Variables(fit_options.parameters, fitted_results.conduction_model)) {
+            ImGui::Text("%s", v.name); ImGui::NextColumn();
+            ImGui::Text("%.4g", fitted_results.*v.field); ImGui::NextColumn();
+        }
         
         ImGui::Columns(1);
         ImGui::Separator();
@@ -722,40 +755,49 @@ void Gui::draw_viewport(unsigned int texture, glm::ivec2 size, Camera& camera) {
     ImGui::End();
 }
 
-struct TraceSample { float t; float v; float i; float r; };
-struct TraceBuffer {
-    int MaxSize; int Offset; ImVector<TraceSample> Data;
-    TraceBuffer(int max_size = 2000) { MaxSize = max_size; Offset = 0; Data.reserve(MaxSize); }
-    void Add(float t, float v, float i, float r) {
-        TraceSample s{t, v, i, r};
-        if (Data.size() < MaxSize) Data.push_back(s);
-        else { Data[Offset] = s; Offset = (Offset + 1) % MaxSize; }
+void Gui::draw_simulation(SimulationWorker& worker, const SimulationSnapshot& state) {
+    ImGui::Begin("Simulation");
+    
+    bool paused = worker.paused();
+    if (ImGui::Checkbox("Paused", &paused)) worker.set_paused(paused);
+    
+    // Fixed integration step, independent of the frame rate
+    float step_us = (float)(worker.fixed_step() * 1e6);
+    if (ImGui::SliderFloat("Step (us)", &step_us, 0.1f, 1000.0f, "%.2f us", ImGuiSliderFlags_Logarithmic)) {
+        worker.set_fixed_step((double)step_us * 1e-6);
     }
-};
-static void SaveToCSV(const TraceBuffer& buf) {
-    std::ofstream file("memristor_data.csv");
-    file << "Time,Voltage,Current,Resistance\n";
-    int count = buf.Data.size();
-    for (int i = 0; i < count; ++i) {
-        const TraceSample& s = buf.Data[i];
-        file << s.t << "," << s.v << "," << s.i << "," << s.r << "\n";
+    
+    bool max_speed = worker.time_scale() == 0.0;
+    if (ImGui::Checkbox("As fast as possible", &max_speed)) worker.set_time_scale(max_speed ? 0.0 : 1.0);
+    if (!max_speed) {
+        float scale = (float)worker.time_scale();
+        if (ImGui::SliderFloat("Speed (x real time)", &scale, 0.001f, 1000.0f, "%.3fx", ImGuiSliderFlags_Logarithmic)) {
+            worker.set_time_scale((double)scale);
+        }
     }
+    
+    ImGui::Separator();
+    ImGui::Text("Simulated time: %.4f s (%llu steps)", state.time, (unsigned long long)state.steps);
+    ImGui::Text("Rate: %.3g steps/s, %.3gx real time", state.steps_per_second, state.real_time_factor);
+    if (state.lagging) {
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Cannot keep up with the requested speed");
+    }
+    ImGui::End();
 }
 
-void Gui::draw_oscilloscope(double time_now, double voltage_now, const PhysicsEngine& physics) {
+void Gui::draw_oscilloscope(TraceRecorder& recorder) {
     ImGui::Begin("Oscilloscope");
-    static TraceBuffer buf(4000);
-    buf.Add((float)time_now, (float)voltage_now, (float)physics.i(), (float)physics.r());
+    recorder.recent(m_trace);
     
-    if (ImPlot::BeginPlot("Hysteresis Loop", ImVec2(-1.0f, -40.0f))) {
+    if (ImPlot::BeginPlot("Hysteresis Loop", ImVec2(-1.0f, -70.0f))) {
         ImPlot::SetupAxes("Voltage (V)", "Current (A)");
         
-        if (buf.Data.size() > 1) {
-            std::vector<float> vx(buf.Data.size());
-            std::vector<float> iy(buf.Data.size());
-            for (int i = 0; i < buf.Data.size(); ++i) { 
-                vx[i] = buf.Data[i].v; 
-                iy[i] = buf.Data[i].i; 
+        if (m_trace.size() > 1) {
+            m_trace_v.resize(m_trace.size());
+            m_trace_i.resize(m_trace.size());
+            for (size_t i = 0; i < m_trace.size(); ++i) { 
+                m_trace_v[i] = (float)m_trace[i].v; 
+                m_trace_i[i] = (float)m_trace[i].i; 
             }
             
             // Set style properties on ImPlotSpec
@@ -763,13 +805,31 @@ void Gui::draw_oscilloscope(double time_now, double voltage_now, const PhysicsEn
             spec.LineColor = ImVec4(0.0f, 0.8f, 1.0f, 1.0f); // Neon Cyan
             spec.LineWeight = 2.5f;
             
-            ImPlot::PlotLine("I-V Curve", vx.data(), iy.data(), (int)vx.size(), spec);
+            ImPlot::PlotLine("I-V Curve", m_trace_v.data(), m_trace_i.data(), (int)m_trace_v.size(), spec);
         }
         
         ImPlot::EndPlot();
     }
     
-    if (ImGui::Button("Export CSV", ImVec2(-1.0f, 25.0f))) { SaveToCSV(buf); }
+    // Recording streams every step to disk on the recorder's writer thread
+    float half = (ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ItemSpacing.x) * 0.5f;
+    if (recorder.recording()) {
+        if (ImGui::Button("Stop Recording", ImVec2(half, 25.0f))) recorder.stop_recording();
+    } else if (ImGui::Button("Record", ImVec2(half, 25.0f))) {
+        std::string err;
+        recorder.start_recording("memristor_trace.mrec", err);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button(recorder.exporting() ? "Exporting..." : "Export CSV", ImVec2(half, 25.0f))) {
+        recorder.export_csv("memristor_data.csv");
+    }
+    std::string err = recorder.last_error();
+    if (!err.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", err.c_str());
+    } else if (recorder.recording() || recorder.recorded() > 0) {
+        ImGui::Text("%s: %llu samples, %llu dropped", recorder.recording() ? "Recording" : "Recorded",
+                    (unsigned long long)recorder.recorded(), (unsigned long long)recorder.dropped());
+    }
     ImGui::End();
 }
 
@@ -5,17 +5,24 @@
 #include <GLFW/glfw3.h>
 #include "physics/Memristor.h"
 #include "utils/Waveform.h"
+#include "utils/TraceRecorder.h"
+#include <vector>
 
 #include "physics/Crossbar.h"
+#include "physics/SimulationWorker.h"
 
 class Gui {
 public:
     explicit Gui(GLFWwindow* window);
     void begin_frame();
-    void draw_controls(MemristorParams& params, WaveformGenerator& waveform, PhysicsEngine& physics);
-    void draw_viewport(unsigned int texture, glm::ivec2 size, class Camera& camera);
-    void draw_oscilloscope(double time_now, double voltage_now, const PhysicsEngine& physics);
+    // draw_controls and draw_menu read and edit the live engine, array and waveform: call them
+    // with SimulationWorker::lock_state() held
+    void draw_controls(MemristorParams& params, WaveformGenerator& waveform, PhysicsEngine& physics,
+                       const SimulationSnapshot& state);
     void draw_menu(MemristorParams& params, WaveformGenerator& waveform, PhysicsEngine& physics);
+    void draw_viewport(unsigned int texture, glm::ivec2 size, class Camera& camera);
+    void draw_simulation(SimulationWorker& worker, const SimulationSnapshot& state);
+    void draw_oscilloscope(TraceRecorder& recorder);
     void end_frame();
     void shutdown();
     
@@ -27,4 +34,8 @@ private:
     bool m_crossbarMode = false;
     bool m_show_sneak_paths = false;
     CrossbarArray m_crossbar;
+    // Oscilloscope window copied from the recorder each frame
+    std::vector<TraceSample> m_trace;
+    std::vector<float> m_trace_v;
+    std::vector<float> m_trace_i;
 };
@@ -5,6 +5,8 @@
 #include "render/Camera.h"
 #include "physics/Memristor.h"
 #include "utils/Waveform.h"
+#include "utils/TraceRecorder.h"
+#include "physics/SimulationWorker.h"
 
 static void glfw_error_callback(int error, const char* description) {
 }
@@ -30,8 +32,7 @@ int main() {
     MemristorParams params;
     PhysicsEngine physics(params);
     WaveformGenerator waveform;
-
-    double lastTime = glfwGetTime();
+    TraceRecorder recorder;
 
 #if defined(__has_include)
 #if __has_include("vendor/stb_image.h")
@@ -46,43 +47,44 @@ int main() {
 #endif
 #endif
     glfwSetWindowTitle(window, "MemristorSim Pro 1.0");
+    // Physics runs on its own thread at a fixed step; the frame loop only reads its snapshots
+    SimulationWorker worker(physics, gui.crossbar(), waveform, &recorder);
+    SimulationSnapshot state;
+    worker.start();
+
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         renderer.resize(display_w, display_h);
 
-        double now = glfwGetTime();
-        double dt = now - lastTime;
-        lastTime = now;
-
-        double voltage = 0.0;
-        if (gui.crossbar_mode()) {
-            gui.crossbar().update(dt);
-        } else {
-            voltage = waveform.get_voltage(now);
-            physics.update(dt, voltage);
-        }
+        worker.set_crossbar_mode(gui.crossbar_mode());
+        worker.snapshot(state);
 
         renderer.begin_scene();
-        if (gui.crossbar_mode()) {
-            renderer.draw_crossbar(camera, gui.crossbar());
+        if (state.crossbar_mode) {
+            renderer.draw_crossbar(camera, state);
         } else {
-            renderer.update_filament(physics.w(), physics.power());
+            renderer.update_filament(state.w, state.power);
             renderer.draw_scene(camera);
         }
         renderer.end_scene();
 
         gui.begin_frame();
-        gui.draw_menu(params, waveform, physics);
-        gui.draw_controls(params, waveform, physics);
+        {
+            auto lock = worker.lock_state();
+            gui.draw_menu(params, waveform, physics);
+            gui.draw_controls(params, waveform, physics, state);
+        }
+        gui.draw_simulation(worker, state);
         gui.draw_viewport(renderer.viewport_texture(), renderer.viewport_size(), camera);
-        gui.draw_oscilloscope(now, voltage, physics);
+        gui.draw_oscilloscope(recorder);
         gui.end_frame();
 
         glfwSwapBuffers(window);
     }
 
+    worker.stop();
     renderer.shutdown();
     gui.shutdown();
     glfwDestroyWindow(window);
@@ -0,0 +1,201 @@
+#include "BatchFitter.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// Table fields: device, path and error are quoted, the rest are plain numbers
+static const char* kTableHeader =
+    "device,path,status,points,mse,R_on,R_off,k_on,k_off,alpha_on,alpha_off,v_on,v_off,"
+    "gamma_sinh,beta_pf,beta_sc,seconds,error";
+
+static std::string quote(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += (c == '\n' || c == '\r') ? ' ' : c;
+    }
+    return out + "\"";
+}
+
+// Splits one CSV line, honouring double-quoted fields with "" escapes
+static std::vector<std::string> split_csv(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t k = 0; k < line.size(); ++k) {
+        char c = line[k];
+        if (quoted) {
+            if (c == '"' && k + 1 < line.size() && line[k + 1] == '"') {
+                fields.back() += '"';
+                ++k;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+static std::string table_row(const BatchFitResult& r) {
+    const MemristorParams& p = r.params;
+    std::ostringstream row;
+    row.precision(10);
+    row << quote(r.device) << "," << quote(r.path) << "," << (r.ok ? "ok" : "failed") << "," << r.points << ","
+        << r.mse << "," << p.R_on << "," << p.R_off << "," << p.k_on << "," << p.k_off << "," << p.alpha_on << ","
+        << p.alpha_off << "," << p.v_on << "," << p.v_off << "," << p.gamma_sinh << "," << p.beta_pf << ","
+        << p.beta_sc << "," << r.seconds << "," << quote(r.error) << "\n";
+    return row.str();
+}
+
+BatchFitter::BatchFitter(size_t workers) : m_pool(workers) {}
+
+const char* BatchFitter::TableHeader() { return kTableHeader; }
+
+std::vector<std::string> BatchFitter::ListDirectory(const std::string& dir, std::string& err) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    fs::directory_iterator it(dir, ec);
+    if (ec) {
+        err = "Could not open directory: " + dir;
+        return files;
+    }
+    for (const auto& entry : it) {
+        if (!entry.is_regular_file()) continue;
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        if (ext == ".csv") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) err = "No .csv files in " + dir;
+    return files;
+}
+
+std::vector<std::string> BatchFitter::ReadManifest(const std::string& manifest, std::string& err) {
+    std::vector<std::string> files;
+    std::ifstream in(manifest);
+    if (!in.is_open()) {
+        err = "Could not open manifest: " + manifest;
+        return files;
+    }
+    fs::path base = fs::path(manifest).parent_path();
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#') continue;
+        fs::path p(line);
+        files.push_back((p.is_relative() ? base / p : p).string());
+    }
+    if (files.empty()) err = "Manifest lists no files: " + manifest;
+    return files;
+}
+
+std::set<std::string> BatchFitter::CompletedPaths(const std::string& table, uint64_t* complete_bytes) {
+    std::set<std::string> done;
+    if (complete_bytes) *complete_bytes = 0;
+    std::ifstream in(table, std::ios::binary);
+    if (!in.is_open()) return done;
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // Every row ends in '\n' (quote() flattens newlines inside fields), so a row without one was
+    // cut short by an interrupted run, wherever the cut fell, and its device is fitted again.
+    // Complete rows must also have every field and a known status.
+    size_t columns = split_csv(kTableHeader).size();
+    size_t pos = text.find('\n');
+    if (pos == std::string::npos) return done;
+    if (complete_bytes) *complete_bytes = pos + 1;
+    for (size_t begin = pos + 1; (pos = text.find('\n', begin)) != std::string::npos; begin = pos + 1) {
+        auto fields = split_csv(text.substr(begin, pos - begin));
+        if (fields.size() != columns || (fields[2] != "ok" && fields[2] != "failed")) continue;
+        done.insert(fields[1]);
+        if (complete_bytes) *complete_bytes = pos + 1;
+    }
+    return done;
+}
+
+std::vector<BatchFitResult> BatchFitter::run(const std::vector<std::string>& files, const MemristorParams& base,
+                                             const FitOptions& options, const std::string& table, std::string& err,
+                                             bool resume, const Progress& progress) {
+    // The table itself is skipped when it sits in the directory being fitted, without counting
+    // as a skipped device
+    std::vector<std::string> pending;
+    uint64_t complete_bytes = 0;
+    std::set<std::string> done = resume ? CompletedPaths(table, &complete_bytes) : std::set<std::string>();
+    std::error_code ec;
+    fs::path table_path = fs::weakly_canonical(table, ec);
+    m_skipped = 0;
+    for (const auto& f : files) {
+        if (fs::weakly_canonical(f, ec) == table_path) continue;
+        if (done.count(f)) {
+            ++m_skipped;
+            continue;
+        }
+        pending.push_back(f);
+    }
+
+    // Fresh table, or append after the last complete row of the previous run, dropping
+    // whatever an interrupted run left after it
+    bool fresh = !resume || complete_bytes == 0;
+    if (!fresh && fs::file_size(table, ec) != complete_bytes) {
+        fs::resize_file(table, complete_bytes, ec);
+        if (ec) {
+            err = "Could not truncate results table: " + table;
+            return {};
+        }
+    }
+    std::ofstream out(table, fresh ? std::ios::trunc : std::ios::app);
+    if (!out.is_open()) {
+        err = "Could not open results table: " + table;
+        return {};
+    }
+    if (fresh) out << kTableHeader << "\n";
+    out.flush();
+
+    // Devices are the unit of parallelism, so each fit runs on the calling worker alone
+    FitOptions per_device = options;
+    per_device.de.workers = 1;
+
+    std::vector<BatchFitResult> results(pending.size());
+    std::mutex table_mutex;
+    size_t finished = 0;
+    m_pool.parallel_for(pending.size(), [&](size_t k, size_t) {
+        auto start = std::chrono::steady_clock::now();
+        BatchFitResult& r = results[k];
+        r.path = pending[k];
+        r.device = fs::path(r.path).stem().string();
+        r.params = base;
+
+        std::string load_err;
+        TraceColumns dataset = MemristorFitter::LoadCSV(r.path, load_err, m_load);
+        if (!load_err.empty()) {
+            r.error = load_err;
+        } else {
+            r.points = dataset.size();
+            r.params = MemristorFitter::Fit(dataset, base, r.mse, per_device);
+            r.ok = true;
+        }
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::string row = table_row(r);
+        std::lock_guard<std::mutex> lock(table_mutex);
+        out << row;
+        out.flush();
+        ++finished;
+        if (progress) progress(r, finished, pending.size());
+    });
+    return results;
+}
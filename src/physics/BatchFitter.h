@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+#include "Optimizer.h"
+#include "../utils/ThreadPool.h"
+
+struct BatchFitResult {
+    std::string device;     // File stem, used as the device id in the table
+    std::string path;
+    bool ok = false;
+    std::string error;
+    size_t points = 0;
+    double mse = 0.0;
+    double seconds = 0.0;
+    MemristorParams params;
+};
+
+// Fits many device CSVs (e.g. one wafer) concurrently: one load + Fit job per file on a
+// ThreadPool, each fit running single-threaded so the cores are spread over devices. Only the
+// datasets of the files currently being fitted are in memory at any time.
+//
+// Every finished device is appended to one CSV table and flushed straight away, so an
+// interrupted run can be resumed: files already listed in the table are skipped. Rows appear
+// in completion order.
+class BatchFitter {
+public:
+    using Progress = std::function<void(const BatchFitResult&, size_t done, size_t total)>;
+
+    explicit BatchFitter(size_t workers = 0);
+
+    size_t workers() const { return m_pool.size(); }
+    // How each device file is read (e.g. TraceLoadOptions::use_cache); parse threads are best
+    // left at 1 since the devices already occupy the cores
+    void set_load_options(const TraceLoadOptions& options) { m_load = options; }
+
+    // *.csv files of a directory, sorted by name
+    static std::vector<std::string> ListDirectory(const std::string& dir, std::string& err);
+    // One CSV path per line ('#' comments and blank lines skipped); relative paths are
+    // resolved against the manifest's directory
+    static std::vector<std::string> ReadManifest(const std::string& manifest, std::string& err);
+    // Paths already recorded in a results table (empty if it does not exist yet). Only complete,
+    // newline-terminated rows count; complete_bytes receives the length of the table up to the
+    // last of them (0 without a header line).
+    static std::set<std::string> CompletedPaths(const std::string& table, uint64_t* complete_bytes = nullptr);
+
+    // Fits every file in `files` that is not in `table` yet (all of them when !resume, which
+    // also starts a fresh table). Returns the results of this run only; err is set when the
+    // table cannot be written.
+    std::vector<BatchFitResult> run(const std::vector<std::string>& files, const MemristorParams& base,
+                                    const FitOptions& options, const std::string& table, std::string& err,
+                                    bool resume = true, const Progress& progress = nullptr);
+
+    // Files the last run() left out because the table already listed them
+    size_t skipped() const { return m_skipped; }
+
+    static const char* TableHeader();
+
+private:
+    ThreadPool m_pool;
+    TraceLoadOptions m_load;
+    size_t m_skipped = 0;
+};
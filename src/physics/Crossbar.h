@@ -1,28 +1,37 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include "Memristor.h"
+#include "DeviceBank.h"
+#include "NodalSolver.h"
+#include "Instrumentation.h"
 
-class CrossbarArray {
+// Algorithm used for the IR-drop nodal solve
+enum class NodalSolverMode { GaussSeidel, Newton };
+
+// Memristor crossbar templated on the scalar type of its devices, node voltages and I/O.
+// CrossbarArray (double) is the reference model; CrossbarArrayF keeps device state, the
+// nodal relaxation and the readout in float32 for inference studies that do not need double
+// precision. Configuration (wire resistance, DAC/ADC ranges, dt) stays in double.
+template <typename T>
+class CrossbarArrayT {
 public:
-    CrossbarArray() {
-        MemristorParams p;
-        p.v_on = -0.8;
-        p.v_off = 0.8;
-        p.k_on = 100.0;
-        p.k_off = -100.0;
-        p.R_on = 100.0;
-        p.R_off = 20000.0;
-        p.w_init = 0.5; // Start with half-conductance state (50% formed)
+    CrossbarArrayT(int rows = 8, int cols = 8)
+        : m_rows(std::max(1, rows)), m_cols(std::max(1, cols)),
+          m_bank((size_t)m_rows * (size_t)m_cols, default_params()) {
+        // Devices and node voltages are stored row-major: cell (i, j) lives at i * cols + j
+        size_t cells = (size_t)m_rows * (size_t)m_cols;
+        m_inputs.resize(m_rows, T(0));
+        m_active_inputs.resize(m_rows, T(0));
+        m_outputs.resize(m_cols, T(0));
+        m_ideal_outputs.resize(m_cols, T(0));
         
-        m_devices.resize(8, std::vector<PhysicsEngine>(8, PhysicsEngine(p)));
-        m_inputs.resize(8, 0.0);
-        m_outputs.resize(8, 0.0);
-        m_ideal_outputs.resize(8, 0.0);
-        
-        m_v_row_nodes.resize(8, std::vector<double>(8, 0.0));
-        m_v_col_nodes.resize(8, std::vector<double>(8, 0.0));
+        m_v_row_nodes.resize(cells, T(0));
+        m_v_col_nodes.resize(cells, T(0));
+        m_v_cell.resize(cells, T(0));
+        m_i_read.resize(cells, T(0));
         
         m_edge_detected_output.resize(8, std::vector<double>(8, 0.0));
         m_edge_detected_input.resize(8, std::vector<double>(8, 0.0));
@@ -31,66 +40,82 @@ public:
         reset();
     }
     
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    
     void reset() {
-        for (int i = 0; i < 8; ++i) {
-            m_inputs[i] = 0.0;
-            m_outputs[i] = 0.0;
-            m_ideal_outputs[i] = 0.0;
-            for (int j = 0; j < 8; ++j) {
-                m_devices[i][j].reset();
-                m_v_row_nodes[i][j] = 0.0;
-                m_v_col_nodes[i][j] = 0.0;
-            }
-        }
+        std::fill(m_inputs.begin(), m_inputs.end(), T(0));
+        std::fill(m_outputs.begin(), m_outputs.end(), T(0));
+        std::fill(m_ideal_outputs.begin(), m_ideal_outputs.end(), T(0));
+        std::fill(m_v_row_nodes.begin(), m_v_row_nodes.end(), T(0));
+        std::fill(m_v_col_nodes.begin(), m_v_col_nodes.end(), T(0));
+        m_bank.reset();
     }
     
-    void set_inputs(const std::vector<double>& voltages) {
-        if (voltages.size() == 8) {
+    void set_inputs(const std::vector<T>& voltages) {
+        if (voltages.size() == (size_t)m_rows) {
             m_inputs = voltages;
         }
     }
     
-    const std::vector<double>& inputs() const { return m_inputs; }
-    const std::vector<double>& outputs() const { return m_outputs; }
+    const std::vector<T>& inputs() const { return m_inputs; }
+    const std::vector<T>& outputs() const { return m_outputs; }
     
-    std::vector<double> differential_outputs() const {
-        std::vector<double> diff(4, 0.0);
-        for (int k = 0; k < 4; ++k) {
+    std::vector<T> differential_outputs() const {
+        std::vector<T> diff(m_cols / 2, T(0));
+        for (int k = 0; k < m_cols / 2; ++k) {
             diff[k] = m_outputs[2 * k] - m_outputs[2 * k + 1];
         }
         return diff;
     }
     
-    double w(int row, int col) const {
-        return m_devices[row][col].w();
+    T w(int row, int col) const {
+        return m_bank.w(idx(row, col));
     }
     
-    double r(int row, int col) const {
-        return m_devices[row][col].r();
+    T r(int row, int col) const {
+        return m_bank.r(idx(row, col));
     }
     
-    double power(int row, int col) const {
-        return m_devices[row][col].power();
+    T power(int row, int col) const {
+        return m_bank.power(idx(row, col));
     }
     
-    double i(int row, int col) const {
-        return m_devices[row][col].i();
+    T i(int row, int col) const {
+        return m_bank.i(idx(row, col));
     }
     
-    double dT(int row, int col) const {
-        return m_devices[row][col].dT();
+    T dT(int row, int col) const {
+        return m_bank.dT(idx(row, col));
     }
 
-    PhysicsEngine& get_device(int row, int col) {
-        return m_devices[row][col];
+    T calculate_current(int row, int col, T voltage_diff) const {
+        return m_bank.calculate_current(idx(row, col), voltage_diff);
     }
+
+    const DeviceBankT<T>& devices() const { return m_bank; }
+    const MemristorParams& params() const { return m_bank.params(); }
     
     void set_params(const MemristorParams& p) {
-        for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                m_devices[i][j].set_params(p);
-            }
-        }
+        m_bank.set_params(p);
+    }
+
+    // Re-key the device noise streams; together with copy_state this makes a sample's result
+    // depend only on the starting state and the seed (D2D scatter is redrawn on reset()).
+    void seed(uint64_t s) { m_bank.seed(s); }
+
+    // Cumulative phase timings, solver iterations and kernel call counts (see CrossbarStats).
+    // They stay zero unless the library is built with MEMRISTORSIM_STATS.
+    const CrossbarStats& stats() const { return m_stats; }
+    void reset_stats() { m_stats = CrossbarStats(); }
+    static constexpr bool stats_enabled() { return kStatsEnabled; }
+
+    // Copy device state and the nodal warm start from a same-shaped array (used by replicas)
+    void copy_state(const CrossbarArrayT& src) {
+        if (src.m_rows != m_rows || src.m_cols != m_cols) return;
+        m_bank.copy_state(src.m_bank);
+        m_v_row_nodes = src.m_v_row_nodes;
+        m_v_col_nodes = src.m_v_col_nodes;
     }
 
     // IR Drop parameters and getters/setters
@@ -99,9 +124,12 @@ public:
     
     double r_wire() const { return m_r_wire; }
     void set_r_wire(double r) { m_r_wire = r; }
+
+    NodalSolverMode solver_mode() const { return m_solver_mode; }
+    void set_solver_mode(NodalSolverMode mode) { m_solver_mode = mode; }
     
-    double v_row_node(int row, int col) const { return m_v_row_nodes[row][col]; }
-    double v_col_node(int row, int col) const { return m_v_col_nodes[row][col]; }
+    T v_row_node(int row, int col) const { return m_v_row_nodes[idx(row, col)]; }
+    T v_col_node(int row, int col) const { return m_v_col_nodes[idx(row, col)]; }
 
     // DAC/ADC getters & setters
     bool enable_dac() const { return m_enable_dac; }
@@ -122,146 +150,306 @@ public:
     double adc_i_max() const { return m_adc_i_max; }
     void set_adc_i_max(double i) { m_adc_i_max = i; }
 
-    double quantize_dac(double v) const {
+    T quantize_dac(T v) const {
         if (!m_enable_dac || m_dac_bits <= 0) return v;
         double v_min = m_dac_v_min;
         double v_max = m_dac_v_max;
-        double clamped = std::max(v_min, std::min(v, v_max));
+        double clamped = std::max(v_min, std::min((double)v, v_max));
         double levels = std::pow(2.0, m_dac_bits) - 1.0;
         double step = (v_max - v_min) / levels;
-        if (step <= 0.0) return clamped;
-        return v_min + std::round((clamped - v_min) / step) * step;
+        if (step <= 0.0) return T(clamped);
+        return T(v_min + std::round((clamped - v_min) / step) * step);
     }
 
-    double quantize_adc(double i) const {
+    T quantize_adc(T i) const {
         if (!m_enable_adc || m_adc_bits <= 0) return i;
         double i_min = m_adc_i_min;
         double i_max = m_adc_i_max;
-        double clamped = std::max(i_min, std::min(i, i_max));
+        double clamped = std::max(i_min, std::min((double)i, i_max));
         double levels = std::pow(2.0, m_adc_bits) - 1.0;
         double step = (i_max - i_min) / levels;
-        if (step <= 0.0) return clamped;
-        return i_min + std::round((clamped - i_min) / step) * step;
+        if (step <= 0.0) return T(clamped);
+        return T(i_min + std::round((clamped - i_min) / step) * step);
     }
     
     void update(double dt) {
+        evaluate(dt, false);
+    }
+
+    // Runs `batch` input vectors through the array in one call. X is batch x rows and Y is
+    // batch x cols, both row-major. Every sample is equivalent to set_inputs + update(dt) +
+    // outputs(); with read_only the devices are only read at their present state, so w, dT,
+    // RTN states and noise streams are left untouched. A read-only sample also solves from a
+    // fixed start (ideal node voltages, default selector splits) and leaves the warm starts of
+    // later updates alone, so its output depends only on the device states and its input.
+    void forward_batch(const T* X, size_t batch, T* Y, double dt = 0.001, bool read_only = false) {
+        for (size_t b = 0; b < batch; ++b) {
+            std::copy_n(X + b * m_rows, m_rows, m_inputs.begin());
+            evaluate(dt, read_only);
+            std::copy(m_outputs.begin(), m_outputs.end(), Y + b * m_cols);
+        }
+    }
+    
+    void program_cell(int row, int col, double w_val) {
+        m_bank.set_w(idx(row, col), T(w_val));
+    }
+    
+    std::pair<int, double> program_cell_write_verify(int row, int col, double w_val, double tolerance = 0.01, int max_pulses = 30) {
+        return m_bank.program_write_verify(idx(row, col), w_val, tolerance, max_pulses);
+    }
+
+    // Ideal programming of the whole array from a row-major rows x cols weight matrix.
+    // Templated on the element type so float32 and float64 buffers are consumed in place.
+    template <typename W>
+    void program_matrix(const W* weights) {
+        size_t cells = m_bank.size();
+        for (size_t k = 0; k < cells; ++k) {
+            m_bank.set_w(k, T(weights[k]));
+        }
+    }
+
+    // Closed-loop write-verify of every cell towards the row-major target matrix.
+    // Returns the total pulse count and total write energy over the array.
+    template <typename W>
+    std::pair<int, double> program_matrix_write_verify(const W* weights, double tolerance = 0.01, int max_pulses = 30) {
+        int total_pulses = 0;
+        double total_energy = 0.0;
+        size_t cells = m_bank.size();
+        for (size_t k = 0; k < cells; ++k) {
+            auto [pulses, energy] = m_bank.program_write_verify(k, (double)weights[k], tolerance, max_pulses);
+            total_pulses += pulses;
+            total_energy += energy;
+        }
+        return {total_pulses, total_energy};
+    }
+
+private:
+    size_t idx(int row, int col) const { return (size_t)row * (size_t)m_cols + (size_t)col; }
+
+    // Adds the time since `mark` to `ticks` and the kernel events since `events` to `kernel`,
+    // then restarts both marks (MEMRISTORSIM_STATS builds only)
+    static void stats_lap(uint64_t& mark, uint64_t& ticks, KernelCounters& events, KernelCounters* kernel) {
+        if constexpr (kStatsEnabled) {
+            uint64_t now = stats_ticks();
+            ticks += now - mark;
+            mark = now;
+            if (kernel) {
+                *kernel += kernel_counters() - events;
+                events = kernel_counters();
+            }
+        }
+    }
+
+    void evaluate(double dt, bool read_only) {
+        uint64_t mark = 0;
+        KernelCounters events;
+        if constexpr (kStatsEnabled) {
+            ++m_stats.updates;
+            mark = stats_ticks();
+            events = kernel_counters();
+        }
+
         // Quantize input voltages using DAC
-        std::vector<double> active_inputs = m_inputs;
-        for (int i = 0; i < 8; ++i) {
-            active_inputs[i] = quantize_dac(m_inputs[i]);
+        for (int i = 0; i < m_rows; ++i) {
+            m_active_inputs[i] = quantize_dac(m_inputs[i]);
+        }
+        stats_lap(mark, m_stats.dac_ticks, events, nullptr);
+
+        // A read swaps in its own node voltages and selector splits, starting from the ideal
+        // crossbar, so neither earlier reads nor the next update see each other's warm starts
+        if (read_only) {
+            begin_read();
         }
 
         // Solve row and column node voltages first based on the active DAC-quantized inputs
-        solve_nodal_voltages_with_inputs(active_inputs);
+        solve_nodal_voltages_with_inputs(m_active_inputs);
+        stats_lap(mark, m_stats.solve_ticks, events, &m_stats.solve_kernel);
 
-        // Step all physical devices based on the actual voltage drop across them
-        for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                double v_diff = m_v_row_nodes[i][j] - m_v_col_nodes[i][j];
-                m_devices[i][j].update(dt, v_diff);
-            }
+        size_t cells = m_v_cell.size();
+        for (size_t k = 0; k < cells; ++k) {
+            m_v_cell[k] = m_v_row_nodes[k] - m_v_col_nodes[k];
         }
+        if (read_only) {
+            // Noise-free read of the present device states
+            m_bank.with_kernel([&](const auto& kern) {
+                for (size_t k = 0; k < cells; ++k) {
+                    m_i_read[k] = m_bank.calculate_current(kern, k, m_v_cell[k]);
+                }
+            });
+        } else {
+            // Step all physical devices based on the actual voltage drop across them
+            m_bank.step(dt, m_v_cell.data());
+        }
+        stats_lap(mark, m_stats.device_ticks, events, &m_stats.device_kernel);
         
         // Compute read-out currents at the virtual ground ammeter terminals
-        for (int j = 0; j < 8; ++j) {
-            double raw_i = 0.0;
-            if (m_enable_ir_drop) {
-                // Current exiting the column j wire segment at index 7 into ground (0.0 V):
-                // I_out = V_col[7][j] / r_wire
-                raw_i = m_v_col_nodes[7][j] / m_r_wire;
-            } else {
-                // Ideal case (0-ohm lines): simply sum the nominal currents of column devices
-                double sum_current = 0.0;
-                for (int i = 0; i < 8; ++i) {
-                    sum_current += m_devices[i][j].i();
+        if (m_enable_ir_drop) {
+            // Current exiting the column j wire segment at the last row into ground (0.0 V):
+            // I_out = V_col[rows-1][j] / r_wire
+            const T* v_col_last = &m_v_col_nodes[idx(m_rows - 1, 0)];
+            const T r_wire = T(m_r_wire);
+            for (int j = 0; j < m_cols; ++j) {
+                m_outputs[j] = v_col_last[j] / r_wire;
+            }
+        } else {
+            // Ideal case (0-ohm lines): simply sum the nominal currents of column devices.
+            // Accumulate row by row so the inner loop walks contiguous cells.
+            std::fill(m_outputs.begin(), m_outputs.end(), T(0));
+            const T* cell_i = read_only ? m_i_read.data() : m_bank.i_data();
+            for (int i = 0; i < m_rows; ++i) {
+                const T* row_i = cell_i + idx(i, 0);
+                for (int j = 0; j < m_cols; ++j) {
+                    m_outputs[j] += row_i[j];
                 }
-                raw_i = sum_current;
             }
-            
-            // Apply ADC quantization to the readout column current
-            m_outputs[j] = quantize_adc(raw_i);
         }
+        
+        // Apply ADC quantization to the readout column currents
+        for (int j = 0; j < m_cols; ++j) {
+            m_outputs[j] = quantize_adc(m_outputs[j]);
+        }
+        if (read_only) {
+            end_read();
+        }
+        stats_lap(mark, m_stats.adc_ticks, events, nullptr);
     }
-    
-    void program_cell(int row, int col, double w_val) {
-        m_devices[row][col].set_w(w_val);
+
+    void begin_read() {
+        size_t cells = m_v_cell.size();
+        m_read_row_nodes.resize(cells);
+        m_read_col_nodes.resize(cells);
+        m_read_v_share.resize(cells);
+        for (int i = 0; i < m_rows; ++i) {
+            std::fill_n(&m_read_row_nodes[idx(i, 0)], m_cols, m_active_inputs[i]);
+        }
+        std::fill(m_read_col_nodes.begin(), m_read_col_nodes.end(), T(0));
+        std::fill(m_read_v_share.begin(), m_read_v_share.end(), T(0.5));
+        m_v_row_nodes.swap(m_read_row_nodes);
+        m_v_col_nodes.swap(m_read_col_nodes);
+        m_bank.swap_v_share(m_read_v_share);
     }
-    
-    std::pair<int, double> program_cell_write_verify(int row, int col, double w_val, double tolerance = 0.01, int max_pulses = 30) {
-        return m_devices[row][col].program_write_verify(w_val, tolerance, max_pulses);
+
+    void end_read() {
+        m_v_row_nodes.swap(m_read_row_nodes);
+        m_v_col_nodes.swap(m_read_col_nodes);
+        m_bank.swap_v_share(m_read_v_share);
     }
-    
-private:
-    void solve_nodal_voltages_with_inputs(const std::vector<double>& inputs) {
+
+    static MemristorParams default_params() {
+        MemristorParams p;
+        p.v_on = -0.8;
+        p.v_off = 0.8;
+        p.k_on = 100.0;
+        p.k_off = -100.0;
+        p.R_on = 100.0;
+        p.R_off = 20000.0;
+        p.w_init = 0.5; // Start with half-conductance state (50% formed)
+        return p;
+    }
+
+    void solve_nodal_voltages_with_inputs(const std::vector<T>& inputs) {
         if (!m_enable_ir_drop) {
             // Ideal crossbar: all row nodes equal input, column nodes are virtual ground
-            for (int i = 0; i < 8; ++i) {
-                for (int j = 0; j < 8; ++j) {
-                    m_v_row_nodes[i][j] = inputs[i];
-                    m_v_col_nodes[i][j] = 0.0;
-                }
+            for (int i = 0; i < m_rows; ++i) {
+                std::fill_n(&m_v_row_nodes[idx(i, 0)], m_cols, inputs[i]);
             }
+            std::fill(m_v_col_nodes.begin(), m_v_col_nodes.end(), T(0));
             return;
         }
 
+        if (m_solver_mode == NodalSolverMode::Newton) {
+            // Newton-Raphson on the full MNA system, warm-started from the previous step's nodes.
+            // If it fails to converge (e.g. at a model discontinuity) relaxation finishes the job.
+            NewtonNodalSolver::Result res = m_newton.solve(m_bank, m_rows, m_cols, m_r_wire, inputs,
+                                                           m_v_row_nodes, m_v_col_nodes);
+            if constexpr (kStatsEnabled) {
+                ++m_stats.newton_solves;
+                m_stats.newton_iterations += (uint64_t)res.iterations;
+                m_stats.last_newton_iterations = res.iterations;
+                m_stats.last_newton_residual = res.residual;
+                if (!res.converged) ++m_stats.newton_fallbacks;
+            }
+            if (res.converged) return;
+        }
+        // The relaxation sweeps run on one device kernel specialized for the present parameters
+        m_bank.with_kernel([&](const auto& kern) { solve_gauss_seidel(kern, inputs); });
+    }
+
+    template <typename K>
+    void solve_gauss_seidel(const K& kern, const std::vector<T>& inputs) {
         // Iterative Modified Nodal Analysis (MNA) using Gauss-Seidel relaxation
         // Diagonally dominant grid solves extremely quickly in a few relaxation sweeps
         int max_iters = 100;
-        double tolerance = 1e-6;
-        double rx = m_r_wire;
-        double ry = m_r_wire;
+        T tolerance = T(1e-6);
+        T rx = T(m_r_wire);
+        T ry = T(m_r_wire);
+        const T half = T(0.5);
+        const int last_row = m_rows - 1;
+        const int last_col = m_cols - 1;
 
+        [[maybe_unused]] int sweeps = 0;
+        T max_diff = T(0);
         for (int iter = 0; iter < max_iters; ++iter) {
-            double max_diff = 0.0;
+            ++sweeps;
+            max_diff = T(0);
 
             // Solve KCL at Row nodes: V_row[i][j]
-            for (int i = 0; i < 8; ++i) {
-                double v_in = inputs[i];
-                for (int j = 0; j < 8; ++j) {
-                    double old_val = m_v_row_nodes[i][j];
-                    double v_left = (j == 0) ? v_in : m_v_row_nodes[i][j - 1];
+            for (int i = 0; i < m_rows; ++i) {
+                T v_in = inputs[i];
+                T* v_row = &m_v_row_nodes[idx(i, 0)];
+                const T* v_col = &m_v_col_nodes[idx(i, 0)];
+                const size_t row_base = idx(i, 0);
+                for (int j = 0; j < m_cols; ++j) {
+                    T old_val = v_row[j];
+                    T v_left = (j == 0) ? v_in : v_row[j - 1];
                     
-                    double v_new = 0.0;
-                    double v_diff = old_val - m_v_col_nodes[i][j];
-                    double i_mem = m_devices[i][j].calculate_current(v_diff);
+                    T v_new = T(0);
+                    T v_diff = old_val - v_col[j];
+                    T i_mem = m_bank.calculate_current(kern, row_base + j, v_diff);
 
-                    if (j == 7) {
+                    if (j == last_col) {
                         // Terminal node: no right-hand segment
                         v_new = v_left - rx * i_mem;
                     } else {
-                        double v_right = m_v_row_nodes[i][j + 1];
-                        v_new = (v_left + v_right - rx * i_mem) / 2.0;
+                        T v_right = v_row[j + 1];
+                        v_new = (v_left + v_right - rx * i_mem) * half;
                     }
 
-                    m_v_row_nodes[i][j] = v_new;
+                    v_row[j] = v_new;
                     max_diff = std::max(max_diff, std::abs(v_new - old_val));
                 }
             }
 
             // Solve KCL at Column nodes: V_col[i][j]
-            for (int j = 0; j < 8; ++j) {
-                for (int i = 0; i < 8; ++i) {
-                    double old_val = m_v_col_nodes[i][j];
-                    double v_new = 0.0;
+            // Sweep row by row (top to bottom) so every access stays within contiguous rows;
+            // each column still sees its nodes updated in top-down Gauss-Seidel order.
+            for (int i = 0; i < m_rows; ++i) {
+                T* v_col = &m_v_col_nodes[idx(i, 0)];
+                const T* v_col_up = (i > 0) ? v_col - m_cols : nullptr;
+                const T* v_col_down = (i < last_row) ? v_col + m_cols : nullptr;
+                const T* v_row = &m_v_row_nodes[idx(i, 0)];
+                const size_t row_base = idx(i, 0);
+                for (int j = 0; j < m_cols; ++j) {
+                    T old_val = v_col[j];
+                    T v_new = T(0);
                     
-                    double v_diff = m_v_row_nodes[i][j] - old_val;
-                    double i_mem = m_devices[i][j].calculate_current(v_diff);
+                    T v_diff = v_row[j] - old_val;
+                    T i_mem = m_bank.calculate_current(kern, row_base + j, v_diff);
 
-                    if (i == 0) {
+                    if (last_row == 0) {
+                        // Single-row array: the only node drains straight into virtual ground
+                        v_new = ry * i_mem;
+                    } else if (i == 0) {
                         // Topmost node: no wire segment above
-                        double v_down = m_v_col_nodes[1][j];
-                        v_new = v_down + ry * i_mem;
-                    } else if (i == 7) {
+                        v_new = v_col_down[j] + ry * i_mem;
+                    } else if (i == last_row) {
                         // Bottommost node connected to virtual ground
-                        double v_up = m_v_col_nodes[6][j];
-                        v_new = (v_up + ry * i_mem) / 2.0;
+                        v_new = (v_col_up[j] + ry * i_mem) * half;
                     } else {
-                        double v_up = m_v_col_nodes[i - 1][j];
-                        double v_down = m_v_col_nodes[i + 1][j];
-                        v_new = (v_up + v_down + ry * i_mem) / 2.0;
+                        v_new = (v_col_up[j] + v_col_down[j] + ry * i_mem) * half;
                     }
 
-                    m_v_col_nodes[i][j] = v_new;
+                    v_col[j] = v_new;
                     max_diff = std::max(max_diff, std::abs(v_new - old_val));
                 }
             }
@@ -270,18 +458,37 @@ private:
                 break;
             }
         }
+        if constexpr (kStatsEnabled) {
+            ++m_stats.gs_solves;
+            m_stats.gs_sweeps += (uint64_t)sweeps;
+            m_stats.last_gs_sweeps = sweeps;
+            m_stats.last_gs_residual = (double)max_diff;
+            m_stats.last_gs_converged = max_diff < tolerance;
+        }
     }
 
-    std::vector<std::vector<PhysicsEngine>> m_devices;
-    std::vector<double> m_inputs;
-    std::vector<double> m_outputs;
-    std::vector<double> m_ideal_outputs;
+    int m_rows;
+    int m_cols;
+    DeviceBankT<T> m_bank;
+    std::vector<T> m_inputs;
+    std::vector<T> m_active_inputs; // DAC-quantized copy of m_inputs
+    std::vector<T> m_outputs;
+    std::vector<T> m_ideal_outputs;
     
-    // Nodal voltages for IR drop calculation
-    std::vector<std::vector<double>> m_v_row_nodes;
-    std::vector<std::vector<double>> m_v_col_nodes;
+    // Nodal voltages for IR drop calculation (row-major, same layout as the device bank)
+    std::vector<T> m_v_row_nodes;
+    std::vector<T> m_v_col_nodes;
+    // Node voltages and selector splits of read-only passes, swapped in by begin_read()
+    std::vector<T> m_read_row_nodes;
+    std::vector<T> m_read_col_nodes;
+    AlignedVector<T> m_read_v_share;
+    std::vector<T> m_v_cell; // Per-cell voltage drop handed to the device bank
+    std::vector<T> m_i_read; // Per-cell currents of a read-only evaluation
     bool m_enable_ir_drop = false;
     double m_r_wire = 1.5; // Wire segment resistance in Ohms
+    NodalSolverMode m_solver_mode = NodalSolverMode::GaussSeidel;
+    NewtonNodalSolver m_newton;
+    CrossbarStats m_stats;
 
     // DAC & ADC Quantization properties
     bool m_enable_dac = false;
@@ -299,3 +506,6 @@ public:
     std::vector<std::vector<double>> m_edge_detected_input;
     std::vector<std::vector<double>> m_kernel_weights;
 };
+
+using CrossbarArray = CrossbarArrayT<double>;
+using CrossbarArrayF = CrossbarArrayT<float>;
@@ -0,0 +1,31 @@
+#include "CrossbarPool.h"
+#include "MemristorKernels.h"
+
+CrossbarPool::CrossbarPool(const CrossbarArray& prototype, size_t workers, uint64_t seed)
+    : CrossbarPool(prototype, std::make_shared<ThreadPool>(workers), seed) {}
+
+CrossbarPool::CrossbarPool(const CrossbarArray& prototype, std::shared_ptr<ThreadPool> pool, uint64_t seed)
+    : m_prototype(prototype), m_pool(pool ? std::move(pool) : std::make_shared<ThreadPool>()), m_seed(seed) {
+    m_replicas.assign(m_pool->size(), m_prototype);
+}
+
+void CrossbarPool::sync(const CrossbarArray& prototype) {
+    m_prototype = prototype;
+    for (auto& replica : m_replicas) replica = m_prototype;
+}
+
+void CrossbarPool::forward_batch(const double* X, size_t batch, double* Y, double dt, bool read_only) {
+    const size_t rows = (size_t)m_prototype.rows();
+    const size_t cols = (size_t)m_prototype.cols();
+
+    // Small arrays are cheap per sample, so hand them out in blocks to keep queue traffic low
+    size_t grain = std::max<size_t>(1, 4096 / (rows * cols));
+    grain = std::min(grain, std::max<size_t>(1, batch / (4 * m_pool->size())));
+
+    m_pool->parallel_for(batch, [&](size_t b, size_t worker) {
+        CrossbarArray& replica = m_replicas[worker];
+        replica.copy_state(m_prototype);
+        replica.seed(mix_seed(m_seed, b));
+        replica.forward_batch(X + b * rows, 1, Y + b * cols, dt, read_only);
+    }, grain);
+}
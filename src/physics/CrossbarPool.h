@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Crossbar.h"
+#include "../utils/ThreadPool.h"
+
+// Parallel batch inference over clones of one programmed CrossbarArray. A single array
+// serializes samples because every update mutates node voltages and device state, so the
+// pool keeps one replica per worker thread and shards the batch across a work-stealing
+// ThreadPool.
+//
+// Every sample starts from the snapshot taken at construction / sync() and reseeds its
+// replica's noise streams from (seed, sample index). Results therefore do not depend on the
+// worker count or on scheduling, but (unlike CrossbarArray::forward_batch) device drift
+// caused by one sample is not carried into the next. Pools that run one after the other may
+// share a ThreadPool; each keeps one replica per thread of it.
+class CrossbarPool {
+public:
+    explicit CrossbarPool(const CrossbarArray& prototype, size_t workers = 0, uint64_t seed = 0x5EED);
+    CrossbarPool(const CrossbarArray& prototype, std::shared_ptr<ThreadPool> pool, uint64_t seed = 0x5EED);
+
+    size_t workers() const { return m_replicas.size(); }
+    uint64_t seed() const { return m_seed; }
+    void set_seed(uint64_t seed) { m_seed = seed; }
+
+    // Re-clone the replicas from a (re)programmed or reconfigured array of the same shape
+    void sync(const CrossbarArray& prototype);
+
+    const CrossbarArray& prototype() const { return m_prototype; }
+
+    // Same contract as CrossbarArray::forward_batch: X is batch x rows, Y is batch x cols
+    void forward_batch(const double* X, size_t batch, double* Y, double dt = 0.001, bool read_only = false);
+
+private:
+    CrossbarArray m_prototype;
+    std::vector<CrossbarArray> m_replicas;
+    std::shared_ptr<ThreadPool> m_pool;
+    uint64_t m_seed;
+};
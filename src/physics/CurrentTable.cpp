@@ -0,0 +1,96 @@
+#include "CurrentTable.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Everything the cell current depends on; the switching dynamics and noise are not part of it
+static std::vector<double> table_key(const MemristorParams& p) {
+    return {
+        p.R_on, p.R_off, p.I_compliance, (double)p.conduction_model, p.gamma_sinh, p.beta_pf, p.beta_sc,
+        p.enable_rtn ? p.rtn_amplitude : -1.0,
+        p.enable_selector ? (double)p.selector_type : -1.0, p.selector_v_th, p.selector_v_gate, p.selector_v_th_trans,
+        p.table_v_max,
+    };
+}
+
+template <typename T>
+CurrentTableT<T>::CurrentTableT(const MemristorParams& p) : m_key(table_key(p)) {
+    const double v_max = p.table_v_max > 0.0 ? p.table_v_max : 1.0;
+    const double h = 2.0 * v_max / (kVoltagePoints - 1);
+    m_v_max = T(v_max);
+    m_inv_h = T(1.0 / h);
+    // sgn(V) makes the Schottky current jump at 0 V, which no interpolant can follow
+    m_exclude = (p.conduction_model == ConductionModel::Schottky) ? T(h) : T(-1);
+    m_planes = p.enable_rtn ? 2 : 1;
+    m_state_points = p.enable_selector ? kStatePoints : 2;
+    for (int j = 0; j < m_state_points; ++j) {
+        double s = (double)j / (m_state_points - 1);
+        double s_next = (double)(j + 1) / (m_state_points - 1);
+        m_w_nodes[j] = T(s * s);
+        m_inv_dw[j] = T(1.0 / (s_next * s_next - s * s));
+    }
+    m_nodes.assign((size_t)m_planes * m_state_points * kVoltagePoints * 2, T(0));
+
+    // Nodes are sampled in double whatever T is, then rounded into the table
+    const MemristorParamsT<double> pd(p);
+    with_device_kernel(pd, DeviceConstants<double>(pd), [&](const auto& kern) {
+        for (int plane = 0; plane < m_planes; ++plane) {
+            for (int j = 0; j < m_state_points; ++j) {
+                double w = (double)m_w_nodes[j];
+                double share = 0.5;
+                T* row = &m_nodes[((size_t)plane * m_state_points + j) * kVoltagePoints * 2];
+                for (int i = 0; i < kVoltagePoints; ++i) {
+                    double v = -v_max + i * h;
+                    double g = 0.0;
+                    row[2 * i] = T(kern.cell_current_and_conductance(w, plane, v, g, share));
+                    row[2 * i + 1] = T(h * g);
+                }
+            }
+        }
+
+        // Self-check at the centre of every grid cell, where the interpolation error peaks
+        for (int plane = 0; plane < m_planes; ++plane) {
+            for (int j = 0; j + 1 < m_state_points; ++j) {
+                double w = 0.5 * ((double)m_w_nodes[j] + (double)m_w_nodes[j + 1]);
+                double share = 0.5;
+                for (int i = 0; i + 1 < kVoltagePoints; ++i) {
+                    double v = -v_max + (i + 0.5) * h;
+                    if (!covers(T(v))) continue;
+                    double exact = kern.cell_current(w, plane, v, share);
+                    double table = (double)current(T(w), plane, T(v));
+                    m_max_error = std::max(m_max_error, std::fabs(table - exact));
+                }
+            }
+        }
+    });
+}
+
+template <typename T>
+bool CurrentTableT<T>::matches(const MemristorParams& p) const {
+    return table_key(p) == m_key;
+}
+
+template <typename T>
+std::shared_ptr<const CurrentTableT<T>> CurrentTableT<T>::shared(const MemristorParams& p) {
+    std::vector<double> key = table_key(p);
+    static std::mutex mutex;
+    static std::map<std::vector<double>, std::weak_ptr<const CurrentTableT>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Drop the tables nobody holds any more, so parameter sweeps do not grow the registry
+    for (auto it = tables.begin(); it != tables.end();) {
+        if (it->second.expired()) it = tables.erase(it);
+        else ++it;
+    }
+    std::shared_ptr<const CurrentTableT> table = tables[key].lock();
+    if (!table) {
+        table = std::make_shared<const CurrentTableT>(p);
+        tables[key] = table;
+    }
+    return table;
+}
+
+template class CurrentTableT<double>;
+template class CurrentTableT<float>;
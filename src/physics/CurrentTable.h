@@ -0,0 +1,137 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Memristor.h"
+#include "MemristorKernels.h"
+#include "../utils/AlignedAllocator.h"
+
+// Tabulated cell current I(V, w) of one parameter set, for MemristorParams::tabulated_current.
+// The table samples the full cell (conduction model, RTN gain, compliance and the series
+// selector split) at kVoltagePoints uniform voltages over [-table_v_max, table_v_max] and
+// kStatePoints states w = (j / (kStatePoints - 1))^2, which crowds the nodes towards w = 0
+// where a selector makes the current bend fastest. Without a selector the current is affine
+// in w, so the rows at w = 0 and w = 1 alone reproduce it exactly and keep the table in cache.
+// Each node stores the current and its exact slope dI/dV; lookups interpolate with a cubic
+// Hermite in V and linearly in w, so the current and the conductance handed to the nodal
+// solver come from one interpolant.
+//
+// Error bound: without a selector the w direction is exact and the O(h^4) Hermite error stays
+// below 2e-9 A with the default grid. With a selector it is ~1e-6 A
+// (4e-6 A at worst for 1T1R); a 1S1R threshold switch snapping on a nearly-off memristor can
+// leave single cells off by up to ~1e-4 A. The table measures itself at the centre of every
+// grid cell when built and max_error() reports the largest deviation found. Voltages outside
+// the grid, and the Schottky model's jump within one cell of 0 V, use the analytic kernel.
+//
+// Only current evaluations read the table: the state integrator still solves the selector
+// split exactly. Tables are immutable once built and shared between every bank and engine
+// whose current-relevant parameters match (see shared()).
+template <typename T>
+class CurrentTableT {
+public:
+    static constexpr int kVoltagePoints = 513;
+    static constexpr int kStatePoints = 65;
+
+    explicit CurrentTableT(const MemristorParams& p);
+
+    // The table for p's current-relevant parameters, built on first use and reused while
+    // any holder keeps it alive. Thread-safe.
+    static std::shared_ptr<const CurrentTableT> shared(const MemristorParams& p);
+    // True when p's current-relevant parameters are the ones this table was built from
+    bool matches(const MemristorParams& p) const;
+
+    bool covers(T v) const {
+        T abs_v = v < T(0) ? -v : v;
+        return abs_v <= m_v_max && abs_v > m_exclude;
+    }
+    T current(T w, int rtn_state, T v) const {
+        T g;
+        return current_and_conductance(w, rtn_state, v, g);
+    }
+    T current_and_conductance(T w, int rtn_state, T v, T& g) const {
+        T x = (v + m_v_max) * m_inv_h;
+        int i = (int)x;
+        if (i > kVoltagePoints - 2) i = kVoltagePoints - 2;
+        T t = x - T(i);
+        w = w < T(0) ? T(0) : (w > T(1) ? T(1) : w);
+        int j = (int)(std::sqrt(w) * T(m_state_points - 1));
+        if (j > m_state_points - 2) j = m_state_points - 2;
+        T u = (w - m_w_nodes[j]) * m_inv_dw[j];
+        int plane = (m_planes > 1 && rtn_state == 1) ? 1 : 0;
+        const T* n0 = &m_nodes[(((size_t)plane * m_state_points + j) * kVoltagePoints + i) * 2];
+        const T* n1 = n0 + kVoltagePoints * 2;
+
+        // Cubic Hermite basis on [V_i, V_i+1] and its derivative
+        T t2 = t * t;
+        T t3 = t2 * t;
+        T h00 = T(2) * t3 - T(3) * t2 + T(1);
+        T h10 = t3 - T(2) * t2 + t;
+        T h01 = T(1) - h00;
+        T h11 = t3 - t2;
+        T d00 = T(6) * (t2 - t);
+        T d10 = T(3) * t2 - T(4) * t + T(1);
+        T d11 = T(3) * t2 - T(2) * t;
+        T i0 = h00 * n0[0] + h10 * n0[1] + h01 * n0[2] + h11 * n0[3];
+        T i1 = h00 * n1[0] + h10 * n1[1] + h01 * n1[2] + h11 * n1[3];
+        T g0 = d00 * (n0[0] - n0[2]) + d10 * n0[1] + d11 * n0[3];
+        T g1 = d00 * (n1[0] - n1[2]) + d10 * n1[1] + d11 * n1[3];
+        g = (g0 + u * (g1 - g0)) * m_inv_h;
+        return i0 + u * (i1 - i0);
+    }
+
+    // Largest |I_table - I| over the grid cell centres, in amperes
+    double max_error() const { return m_max_error; }
+
+private:
+    T m_v_max;
+    T m_inv_h;
+    T m_exclude;           // |V| at or below which lookups fall back to the analytic kernel
+    int m_planes = 1;      // One plane per RTN state when RTN is enabled
+    int m_state_points = kStatePoints;   // w rows; 2 (w = 0, 1) suffice without a selector
+    double m_max_error = 0.0;
+    std::vector<double> m_key;   // Current-relevant parameters the table was built from
+    T m_w_nodes[kStatePoints];   // State of each w row
+    T m_inv_dw[kStatePoints];     // 1 / (w_j+1 - w_j)
+    // [plane][w node][V node][I, h * dI/dV]
+    AlignedVector<T> m_nodes;
+};
+
+using CurrentTable = CurrentTableT<double>;
+using CurrentTableF = CurrentTableT<float>;
+
+extern template class CurrentTableT<double>;
+extern template class CurrentTableT<float>;
+
+// A DeviceKernel whose cell-current evaluations read a CurrentTable where it covers the bias.
+// Everything else, the series split for the integrator included, is the wrapped kernel's.
+template <class Kernel>
+struct TabulatedKernel : Kernel {
+    using T = typename Kernel::scalar;
+    const CurrentTableT<T>* table;
+
+    T cell_current(T w, int rtn_state, T voltage_diff, T& share) const {
+        if (table->covers(voltage_diff)) return table->current(w, rtn_state, voltage_diff);
+        return Kernel::cell_current(w, rtn_state, voltage_diff, share);
+    }
+    T cell_current(T w, int rtn_state, T voltage_diff) const {
+        if (table->covers(voltage_diff)) return table->current(w, rtn_state, voltage_diff);
+        return Kernel::cell_current(w, rtn_state, voltage_diff);
+    }
+    T cell_current_and_conductance(T w, int rtn_state, T voltage_diff, T& g_cell, T& share) const {
+        if (table->covers(voltage_diff)) return table->current_and_conductance(w, rtn_state, voltage_diff, g_cell);
+        return Kernel::cell_current_and_conductance(w, rtn_state, voltage_diff, g_cell, share);
+    }
+    T cell_current_and_conductance(T w, int rtn_state, T voltage_diff, T& g_cell) const {
+        if (table->covers(voltage_diff)) return table->current_and_conductance(w, rtn_state, voltage_diff, g_cell);
+        return Kernel::cell_current_and_conductance(w, rtn_state, voltage_diff, g_cell);
+    }
+};
+
+// Calls f with kern, or with kern reading from table when one is given
+template <class Kernel, typename F>
+static inline decltype(auto) with_tabulated_kernel(const Kernel& kern, const CurrentTableT<typename Kernel::scalar>* table,
+                                                   F&& f) {
+    if (table) return f(TabulatedKernel<Kernel>{kern, table});
+    return f(kern);
+}
@@ -0,0 +1,369 @@
+#include "DeviceBank.h"
+#include "MemristorKernels.h"
+#include <algorithm>
+#include <cmath>
+
+// x^n for 0 <= n < 32 with a fixed five-step trip count and no data-dependent branches,
+// so it unrolls into multiply/blend sequences inside vectorized device loops.
+template <typename T>
+static inline T pow_int_lane(T x, int n) {
+    T result = T(1);
+    for (int bit = 0; bit < 5; ++bit) {
+        result *= (n & (1 << bit)) ? x : T(1);
+        x *= x;
+    }
+    return result;
+}
+
+// Branchless form of memristor_dw_dt for integral alpha exponents: both the SET and RESET
+// terms are evaluated and the active one is selected, which keeps every lane on one path.
+template <typename T>
+static inline T dw_dt_lane(const MemristorParamsT<T>& p, int alpha_on_int, int alpha_off_int,
+                           T k_on, T k_off, T v, T w, T dT) {
+    const T one = T(1);
+    w = std::min(std::max(w, T(0)), one);
+    T w2 = w * w;
+    T w4 = w2 * w2;
+    T wm = w - one;
+    T wm2 = wm * wm;
+    T wm4 = wm2 * wm2;
+
+    T dw_reset = k_off * pow_int_lane((v / p.v_off) - one, alpha_off_int) * (one - wm4 * wm4);
+    T dw_set = k_on * pow_int_lane((v / p.v_on) - one, alpha_on_int) * (one - w4 * w4);
+    T dw = (v > p.v_off) ? dw_reset : ((v < p.v_on) ? dw_set : T(0));
+
+    T thermal_decay = -std::abs(k_off) * ((dT - p.T_critical) / p.T_critical) * w;
+    return dw + ((dT > p.T_critical) ? thermal_decay : T(0));
+}
+
+template <typename T>
+DeviceBankT<T>::DeviceBankT(size_t count, const MemristorParams& p)
+    : m_params(p), m_kparams(p), m_consts(m_kparams),
+      m_table(p.tabulated_current ? CurrentTableT<T>::shared(p) : nullptr),
+      m_w(count, T(p.w_init)), m_r(count, T(0)), m_i(count, T(0)), m_power(count, T(0)), m_dT(count, T(0)),
+      m_rtn_state(count, 0),
+      m_w_init(count, T(p.w_init)), m_k_on(count, T(p.k_on)), m_k_off(count, T(p.k_off)),
+      m_h_adaptive(count, 0.0), m_v_share(count, T(0.5)),
+      m_v_mem(count, T(0)), m_w_stage(count, T(0)), m_k_stage(count, T(0)), m_k_acc(count, T(0)),
+      m_noise(count, 0.0), m_v_single(count, T(0)), m_subthreshold(count, 0) {
+    apply_d2d_variability();
+    std::copy(m_w_init.begin(), m_w_init.end(), m_w.begin());
+}
+
+template <typename T>
+void DeviceBankT<T>::reset() {
+    apply_d2d_variability();
+    std::copy(m_w_init.begin(), m_w_init.end(), m_w.begin());
+    std::fill(m_dT.begin(), m_dT.end(), T(0));
+    std::fill(m_rtn_state.begin(), m_rtn_state.end(), 0);
+    std::fill(m_v_share.begin(), m_v_share.end(), T(0.5));
+    std::fill(m_h_adaptive.begin(), m_h_adaptive.end(), 0.0);
+}
+
+template <typename T>
+void DeviceBankT<T>::set_params(const MemristorParams& p) {
+    m_params = p;
+    m_kparams = MemristorParamsT<T>(p);
+    m_consts = DeviceConstants<T>(m_kparams);
+    // Parameter edits that leave the cell current alone (e.g. switching rates) keep the table
+    if (!p.tabulated_current) m_table = nullptr;
+    else if (!m_table || !m_table->matches(p)) m_table = CurrentTableT<T>::shared(p);
+    apply_d2d_variability();
+}
+
+template <typename T>
+void DeviceBankT<T>::seed(uint64_t s) {
+    m_rng.set_seed(s);
+    m_step = 0;
+}
+
+template <typename T>
+void DeviceBankT<T>::copy_state(const DeviceBankT& src) {
+    if (src.size() != size()) return;
+    std::copy(src.m_w.begin(), src.m_w.end(), m_w.begin());
+    std::copy(src.m_r.begin(), src.m_r.end(), m_r.begin());
+    std::copy(src.m_i.begin(), src.m_i.end(), m_i.begin());
+    std::copy(src.m_power.begin(), src.m_power.end(), m_power.begin());
+    std::copy(src.m_dT.begin(), src.m_dT.end(), m_dT.begin());
+    std::copy(src.m_rtn_state.begin(), src.m_rtn_state.end(), m_rtn_state.begin());
+    std::copy(src.m_v_share.begin(), src.m_v_share.end(), m_v_share.begin());
+    std::copy(src.m_h_adaptive.begin(), src.m_h_adaptive.end(), m_h_adaptive.begin());
+}
+
+template <typename T>
+void DeviceBankT<T>::apply_d2d_variability() {
+    m_alpha_on_int = integral_exponent(m_params.alpha_on);
+    m_alpha_off_int = integral_exponent(m_params.alpha_off);
+
+    size_t n = size();
+    if (!m_params.enable_variability) {
+        std::fill(m_w_init.begin(), m_w_init.end(), T(m_params.w_init));
+        std::fill(m_k_on.begin(), m_k_on.end(), T(m_params.k_on));
+        std::fill(m_k_off.begin(), m_k_off.end(), T(m_params.k_off));
+        return;
+    }
+    for (size_t k = 0; k < n; ++k) {
+        // D2D draws are a fixed property of (seed, device): reset() restores the same array
+        double z_w, z_on;
+        m_rng.normal_pair(k, RngStream::D2D, 0, z_w, z_on);
+        double z_off = m_rng.normal(k, RngStream::D2D, 1);
+
+        // D2D w_init: Normal distribution
+        double w_var = z_w * m_params.sigma_w_init;
+        m_w_init[k] = T(clamp01(m_params.w_init + w_var));
+
+        // D2D k_on, k_off: Log-normal distribution (exponential barrier changes)
+        double log_k_on_var = z_on * m_params.sigma_k_on;
+        double log_k_off_var = z_off * m_params.sigma_k_on;
+        m_k_on[k] = T(m_params.k_on * std::pow(10.0, log_k_on_var));
+        m_k_off[k] = T(m_params.k_off * std::pow(10.0, log_k_off_var));
+    }
+}
+
+template <typename T>
+void DeviceBankT<T>::step(double dt, const T* v_cell) {
+    with_kernel([&](const auto& kern) { step_range(kern, 0, size(), dt, v_cell); });
+}
+
+template <typename T>
+void DeviceBankT<T>::step_device(size_t k, double dt, T voltage) {
+    m_v_single[k] = voltage;
+    with_kernel([&](const auto& kern) { step_range(kern, k, k + 1, dt, m_v_single.data()); });
+}
+
+template <typename T>
+T DeviceBankT<T>::rk4_device(size_t k, double dt, T v_mem) const {
+    return rk4_step(m_kparams, m_alpha_on_int, m_alpha_off_int, m_k_on[k], m_k_off[k], v_mem, m_w[k], m_dT[k], dt);
+}
+
+template <typename T>
+T DeviceBankT<T>::adaptive_device(size_t k, double dt, T v_mem, int& substeps, bool& failed) {
+    const MemristorParamsT<T>& p = m_kparams;
+    const int a_on = m_alpha_on_int;
+    const int a_off = m_alpha_off_int;
+    const T k_on = m_k_on[k];
+    const T k_off = m_k_off[k];
+    const T dT = m_dT[k];
+    return integrate_embedded_rk(p.integrator,
+                                 [&](T w) { return memristor_dw_dt(p, a_on, a_off, k_on, k_off, v_mem, w, dT); },
+                                 m_w[k], dt, p.integrator_rtol, p.integrator_atol, m_h_adaptive[k], substeps, failed);
+}
+
+template <typename T>
+void DeviceBankT<T>::integrate_rk4(size_t begin, size_t end, double dt, const T* v_mem) {
+    const MemristorParamsT<T>& p = m_kparams;
+    const int a_on = m_alpha_on_int;
+    const int a_off = m_alpha_off_int;
+    const T h = T(dt);
+    const T half = T(0.5 * dt);
+    const T sixth = T(dt / 6.0);
+    T* w = m_w.data();
+    const T* dT = m_dT.data();
+    const T* k_on = m_k_on.data();
+    const T* k_off = m_k_off.data();
+    T* ws = m_w_stage.data();
+    T* kq = m_k_stage.data();
+    T* acc = m_k_acc.data();
+
+    if (a_on < 0 || a_off < 0) {
+        // Non-integral alpha exponents need std::pow: integrate device by device
+        for (size_t k = begin; k < end; ++k) ws[k] = rk4_device(k, dt, v_mem[k]);
+        return;
+    }
+
+    // RK4 evaluated stage by stage across the whole range; each pass is a flat SIMD loop.
+    for (size_t k = begin; k < end; ++k) {
+        kq[k] = dw_dt_lane(p, a_on, a_off, k_on[k], k_off[k], v_mem[k], w[k], dT[k]);
+        acc[k] = kq[k];
+    }
+    for (size_t k = begin; k < end; ++k) {
+        kq[k] = dw_dt_lane(p, a_on, a_off, k_on[k], k_off[k], v_mem[k], w[k] + half * kq[k], dT[k]);
+        acc[k] += T(2) * kq[k];
+    }
+    for (size_t k = begin; k < end; ++k) {
+        kq[k] = dw_dt_lane(p, a_on, a_off, k_on[k], k_off[k], v_mem[k], w[k] + half * kq[k], dT[k]);
+        acc[k] += T(2) * kq[k];
+    }
+    for (size_t k = begin; k < end; ++k) {
+        kq[k] = dw_dt_lane(p, a_on, a_off, k_on[k], k_off[k], v_mem[k], w[k] + h * kq[k], dT[k]);
+        acc[k] += kq[k];
+        ws[k] = w[k] + sixth * acc[k];
+    }
+}
+
+template <typename T>
+template <typename K>
+void DeviceBankT<T>::step_range(const K& kern, size_t begin, size_t end, double dt, const T* v_cell) {
+    if (dt <= 0.0 || begin >= end) return;
+    const MemristorParamsT<T>& p = m_kparams;
+    size_t count = end - begin;
+    const uint64_t step = m_step++;
+
+    // Read fast path: below both switching thresholds dw/dt is exactly zero, so only the
+    // switching devices need the selector solve and the integrator
+    int32_t* sub = m_subthreshold.data();
+    size_t switching = 0;
+    for (size_t k = begin; k < end; ++k) {
+        sub[k] = is_subthreshold(p, v_cell[k], m_dT[k]) ? 1 : 0;
+        switching += (size_t)(1 - sub[k]);
+    }
+
+    // Integrate state variable w; the new states land in m_w_stage
+    T* w_new = m_w_stage.data();
+    m_last_substeps = (long long)switching;
+    m_integrator_failures = 0;
+    if (switching == 0) {
+        std::copy(m_w.begin() + begin, m_w.begin() + end, m_w_stage.begin() + begin);
+    } else if (p.integrator != IntegratorMode::RK4) {
+        // Embedded RK pairs choose their own substeps, so every switching device runs alone
+        m_last_substeps = 0;
+        for (size_t k = begin; k < end; ++k) {
+            if (sub[k]) {
+                w_new[k] = m_w[k];
+            } else {
+                int substeps = 0;
+                bool failed = false;
+                T v_mem = kern.series_v_mem(m_w[k], m_rtn_state[k], v_cell[k], m_v_share[k]);
+                w_new[k] = adaptive_device(k, dt, v_mem, substeps, failed);
+                m_last_substeps += substeps;
+                m_integrator_failures += failed ? 1 : 0;
+            }
+        }
+    } else if (switching * 4 < count) {
+        // Few writers among many readers: integrate the switching devices one by one
+        for (size_t k = begin; k < end; ++k) {
+            if (sub[k]) {
+                w_new[k] = m_w[k];
+            } else {
+                T v_mem = kern.series_v_mem(m_w[k], m_rtn_state[k], v_cell[k], m_v_share[k]);
+                w_new[k] = rk4_device(k, dt, v_mem);
+            }
+        }
+    } else {
+        // Solve for the voltage across the memristor component (1S1R / 1T1R series drop).
+        // Sub-threshold lanes keep the raw bias, which leaves their dw/dt at zero.
+        const T* v_mem = v_cell;
+        if constexpr (K::policy::selector != SelectorKind::None) {
+            for (size_t k = begin; k < end; ++k) {
+                m_v_mem[k] = sub[k] ? v_cell[k] : kern.series_v_mem(m_w[k], m_rtn_state[k], v_cell[k], m_v_share[k]);
+            }
+            v_mem = m_v_mem.data();
+        }
+        integrate_rk4(begin, end, dt, v_mem);
+    }
+
+    // Apply C2C write noise (stochastic SDE term: sigma * sqrt(dt) * N(0, 1))
+    if (p.enable_variability && (switching > 0 || p.subthreshold_c2c)) {
+        m_rng.fill_normals(begin, count, RngStream::C2C, step, &m_noise[begin]);
+        double scale = p.sigma_c2c * std::sqrt(dt);
+        double sub_scale = p.subthreshold_c2c ? scale : 0.0;
+        for (size_t k = begin; k < end; ++k) w_new[k] += T((sub[k] ? sub_scale : scale) * m_noise[k]);
+    }
+
+    // Clamp and refresh the state-based equivalent resistance
+    T r_on = p.R_on;
+    T r_span = p.R_off - p.R_on;
+    T* w = m_w.data();
+    T* r = m_r.data();
+    for (size_t k = begin; k < end; ++k) {
+        T wk = std::min(std::max(w_new[k], T(0)), T(1));
+        w[k] = wk;
+        r[k] = r_on + r_span * (T(1) - wk);
+    }
+
+    // RTN state update first
+    if (K::policy::rtn && (switching > 0 || p.subthreshold_rtn)) {
+        double p_capture = 1.0 - std::exp(-dt / p.rtn_tau_c);
+        double p_emission = 1.0 - std::exp(-dt / p.rtn_tau_e);
+        for (size_t k = begin; k < end; ++k) {
+            if (sub[k] && !p.subthreshold_rtn) continue;
+            double r_val = m_rng.uniform(k, RngStream::RTN, step);
+            if (m_rtn_state[k] == 0) {
+                if (r_val < p_capture) m_rtn_state[k] = 1;
+            } else {
+                if (r_val < p_emission) m_rtn_state[k] = 0;
+            }
+        }
+    }
+
+    // Raw cell currents, then realistic read thermal current noise (5% SD). The series solve
+    // starts from the split found for the integrator above, which w has barely moved.
+    T* i = m_i.data();
+    for (size_t k = begin; k < end; ++k) {
+        i[k] = kern.cell_current(w[k], m_rtn_state[k], v_cell[k], m_v_share[k]);
+    }
+    if constexpr (kStatsEnabled) kernel_counters().current_calls += count;
+    if (p.enable_read_noise) {
+        m_rng.fill_normals(begin, count, RngStream::Read, step, &m_noise[begin]);
+        for (size_t k = begin; k < end; ++k) {
+            i[k] += T(m_noise[k]) * (T(0.05) * i[k]);
+        }
+    }
+
+    // Instantaneous power dissipation and the first-order thermal lag
+    double tau_thermal = 0.01;
+    T lag = T(dt / (dt + tau_thermal));
+    T theta = p.theta_thermal;
+    T* power = m_power.data();
+    T* dTv = m_dT.data();
+    for (size_t k = begin; k < end; ++k) {
+        power[k] = std::fabs(i[k] * v_cell[k]);
+        dTv[k] += lag * (power[k] * theta - dTv[k]);
+    }
+}
+
+template <typename T>
+void DeviceBankT<T>::set_w(size_t k, T w) {
+    m_w[k] = clamp01(w);
+    m_r[k] = m_kparams.R_on + (m_kparams.R_off - m_kparams.R_on) * (T(1) - m_w[k]);
+}
+
+template <typename T>
+T DeviceBankT<T>::calculate_current(size_t k, T voltage_diff) const {
+    return with_kernel([&](const auto& kern) { return calculate_current(kern, k, voltage_diff); });
+}
+
+template <typename T>
+T DeviceBankT<T>::calculate_current_and_conductance(size_t k, T voltage_diff, T& g_cell) const {
+    return with_kernel([&](const auto& kern) {
+        return calculate_current_and_conductance(kern, k, voltage_diff, g_cell);
+    });
+}
+
+template <typename T>
+std::pair<int, double> DeviceBankT<T>::program_write_verify(size_t k, double w_target, double tolerance, int max_pulses) {
+    int pulses = 0;
+    double energy = 0.0;
+    double dt = 0.001; // 1 ms pulse width
+
+    w_target = clamp01(w_target);
+
+    for (int pulse = 0; pulse < max_pulses; ++pulse) {
+        double diff = w_target - m_w[k];
+        if (std::abs(diff) <= tolerance) {
+            break;
+        }
+
+        double v_pulse = 0.0;
+        if (diff > 0.0) {
+            // Needs SET: Apply negative voltage pulse (v_on is negative)
+            double factor = std::pow(diff / tolerance, 0.25);
+            v_pulse = std::max(m_params.v_on - 1.2, m_params.v_on - 0.4 * factor);
+        } else {
+            // Needs RESET: Apply positive voltage pulse (v_off is positive)
+            double factor = std::pow((-diff) / tolerance, 0.25);
+            v_pulse = std::min(m_params.v_off + 1.2, m_params.v_off + 0.4 * factor);
+        }
+
+        step_device(k, dt, T(v_pulse));
+
+        // Accumulate energy: E = |I * V| * dt
+        energy += std::abs(m_i[k] * v_pulse) * dt;
+        pulses++;
+    }
+
+    return {pulses, energy};
+}
+
+template class DeviceBankT<double>;
+template class DeviceBankT<float>;
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include "Memristor.h"
+#include "CurrentTable.h"
+#include "MemristorKernels.h"
+#include "../utils/AlignedAllocator.h"
+
+// Structure-of-arrays storage for a population of memristors that share one MemristorParams.
+// Per-device state (w, dT, rtn_state, ...) and the per-device D2D-scattered parameters
+// (w_init, k_on, k_off) live in separate 64-byte aligned arrays, and step() integrates the
+// whole population pass by pass so the RK4 stages, resistance update and thermal lag run as
+// straight loops over contiguous memory that the compiler can pack into AVX2/AVX-512 lanes.
+// Devices read below both switching thresholds bypass the integrator altogether. Current
+// evaluations go through a DeviceKernel specialized once per step (or per solver sweep via
+// with_kernel) on the conduction model, selector and RTN flag.
+//
+// Noise comes from a counter-based CounterRng keyed by (seed, device index, stream, step), so
+// every cell has its own independent stream and the noise can be generated in bulk.
+//
+// T is the scalar type of the device state and math. DeviceBank (double) is the reference;
+// DeviceBankF keeps every lane in float32, which doubles the SIMD width of the device loops
+// and halves their memory traffic. Noise is drawn in double and rounded into the lanes.
+template <typename T>
+class DeviceBankT {
+public:
+    DeviceBankT(size_t count, const MemristorParams& p);
+
+    size_t size() const { return m_w.size(); }
+    void reset();
+    const MemristorParams& params() const { return m_params; }
+    void set_params(const MemristorParams& p);
+
+    // Re-key the noise streams (D2D draws on the next reset(), C2C, RTN, read noise) and
+    // restart their step counter.
+    void seed(uint64_t s);
+    // Copy the dynamic device state (w, dT, RTN, last currents) from a same-sized bank,
+    // leaving this bank's D2D-scattered parameters and RNG untouched.
+    void copy_state(const DeviceBankT& src);
+
+    // Advance every device by dt; v_cell[k] is the total voltage across cell k (selector + memristor).
+    void step(double dt, const T* v_cell);
+    // Advance a single device, e.g. for per-cell programming pulses.
+    void step_device(size_t k, double dt, T voltage);
+
+    T w(size_t k) const { return m_w[k]; }
+    T r(size_t k) const { return m_r[k]; }
+    T i(size_t k) const { return m_i[k]; }
+    T power(size_t k) const { return m_power[k]; }
+    T dT(size_t k) const { return m_dT[k]; }
+    const T* i_data() const { return m_i.data(); }
+    // Accepted integrator substeps summed over the devices of the last step (RK4 counts one)
+    long long last_substeps() const { return m_last_substeps; }
+    // Devices whose adaptive integration gave up on a non-finite error estimate in the last step
+    long long last_integrator_failures() const { return m_integrator_failures; }
+
+    void set_w(size_t k, T w);
+    T calculate_current(size_t k, T voltage_diff) const;
+    T calculate_current_and_conductance(size_t k, T voltage_diff, T& g_cell) const;
+
+    // Runs f(kernel) with the DeviceKernel specialized for the present parameters, so a sweep
+    // over many cells pays for one dispatch; the kernel is then passed to the overloads below.
+    // With tabulated_current the kernel reads cell currents from the shared CurrentTable.
+    // With a selector every evaluation warm-starts the series solve from the device's last one
+    // and updates it, so concurrent calls must not touch the same device.
+    template <typename F>
+    decltype(auto) with_kernel(F&& f) const {
+        return with_device_kernel(m_kparams, m_consts, [&](const auto& kern) -> decltype(auto) {
+            return with_tabulated_kernel(kern, m_table.get(), f);
+        });
+    }
+    template <typename K>
+    T calculate_current(const K& kern, size_t k, T voltage_diff) const {
+        if constexpr (kStatsEnabled) ++kernel_counters().current_calls;
+        return kern.cell_current(m_w[k], m_rtn_state[k], voltage_diff, m_v_share[k]);
+    }
+    template <typename K>
+    T calculate_current_and_conductance(const K& kern, size_t k, T voltage_diff, T& g_cell) const {
+        if constexpr (kStatsEnabled) ++kernel_counters().current_calls;
+        return kern.cell_current_and_conductance(m_w[k], m_rtn_state[k], voltage_diff, g_cell, m_v_share[k]);
+    }
+    std::pair<int, double> program_write_verify(size_t k, double w_target, double tolerance = 0.01, int max_pulses = 30);
+
+    // Exchanges the series-split warm starts with `shares` (one per device), so a pass that must
+    // not disturb them can run on its own set and swap them back afterwards
+    void swap_v_share(AlignedVector<T>& shares) const {
+        if (shares.size() == m_v_share.size()) m_v_share.swap(shares);
+    }
+
+private:
+    void apply_d2d_variability();
+    template <typename K>
+    void step_range(const K& kern, size_t begin, size_t end, double dt, const T* v_cell);
+    void integrate_rk4(size_t begin, size_t end, double dt, const T* v_mem);
+    T rk4_device(size_t k, double dt, T v_mem) const;
+    T adaptive_device(size_t k, double dt, T v_mem, int& substeps, bool& failed);
+
+    MemristorParams m_params;
+    MemristorParamsT<T> m_kparams;   // m_params with the device fields in T, as used by the kernels
+    DeviceConstants<T> m_consts;     // Hoisted conduction / selector constants of m_kparams
+    std::shared_ptr<const CurrentTableT<T>> m_table;   // Set when m_params.tabulated_current
+    int m_alpha_on_int = -1;
+    int m_alpha_off_int = -1;
+    long long m_last_substeps = 0;
+    long long m_integrator_failures = 0;
+
+    // Per-device state
+    AlignedVector<T> m_w;
+    AlignedVector<T> m_r;
+    AlignedVector<T> m_i;
+    AlignedVector<T> m_power;
+    AlignedVector<T> m_dT;
+    AlignedVector<int32_t> m_rtn_state;
+
+    // Per-device active (D2D-scattered) parameters
+    AlignedVector<T> m_w_init;
+    AlignedVector<T> m_k_on;
+    AlignedVector<T> m_k_off;
+    AlignedVector<double> m_h_adaptive;   // Per-device step size carried by the adaptive integrators
+    // Memristor share of the cell bias from each device's last series-selector solve; the
+    // warm start of its next one, whether from step() or from a solver's current evaluation
+    mutable AlignedVector<T> m_v_share;
+
+    // Scratch lanes reused across steps
+    AlignedVector<T> m_v_mem;
+    AlignedVector<T> m_w_stage;
+    AlignedVector<T> m_k_stage;
+    AlignedVector<T> m_k_acc;
+    AlignedVector<double> m_noise;        // Bulk noise draws (double, rounded into the lanes)
+    AlignedVector<T> m_v_single;
+    AlignedVector<int32_t> m_subthreshold;
+
+    CounterRng m_rng;
+    uint64_t m_step = 0;    // Counter of the C2C / RTN / read-noise draws, one per step_range call
+};
+
+using DeviceBank = DeviceBankT<double>;
+using DeviceBankF = DeviceBankT<float>;
+
+extern template class DeviceBankT<double>;
+extern template class DeviceBankT<float>;
@@ -0,0 +1,100 @@
+#pragma once
+#include <cmath>
+
+// Forward-mode dual number: a value plus its derivatives with respect to N seeded inputs.
+// Running the generic device kernels on Dual<N> yields the value and its gradient in one pass.
+// Comparisons look at the value only, so the kernels' branches (thresholds, clamps) behave
+// exactly as in double arithmetic and the derivative is that of the active branch.
+template <int N>
+struct Dual {
+    double v = 0.0;
+    double d[N] = {};
+
+    Dual() = default;
+    Dual(double value) : v(value) {}
+
+    // Independent variable number i with value x and slope dx
+    static Dual Seed(double x, int i, double dx = 1.0) {
+        Dual r(x);
+        r.d[i] = dx;
+        return r;
+    }
+
+    Dual& operator+=(const Dual& b) { v += b.v; for (int k = 0; k < N; ++k) d[k] += b.d[k]; return *this; }
+    Dual& operator-=(const Dual& b) { v -= b.v; for (int k = 0; k < N; ++k) d[k] -= b.d[k]; return *this; }
+    Dual& operator*=(const Dual& b) { *this = *this * b; return *this; }
+    Dual& operator/=(const Dual& b) { *this = *this / b; return *this; }
+
+    friend Dual operator-(const Dual& a) { Dual r; r.v = -a.v; for (int k = 0; k < N; ++k) r.d[k] = -a.d[k]; return r; }
+    friend Dual operator+(Dual a, const Dual& b) { return a += b; }
+    friend Dual operator-(Dual a, const Dual& b) { return a -= b; }
+    friend Dual operator*(const Dual& a, const Dual& b) {
+        Dual r(a.v * b.v);
+        for (int k = 0; k < N; ++k) r.d[k] = a.d[k] * b.v + a.v * b.d[k];
+        return r;
+    }
+    friend Dual operator/(const Dual& a, const Dual& b) {
+        Dual r(a.v / b.v);
+        double inv = 1.0 / b.v;
+        for (int k = 0; k < N; ++k) r.d[k] = (a.d[k] - r.v * b.d[k]) * inv;
+        return r;
+    }
+    friend Dual operator+(Dual a, double b) { a.v += b; return a; }
+    friend Dual operator+(double a, Dual b) { b.v += a; return b; }
+    friend Dual operator-(Dual a, double b) { a.v -= b; return a; }
+    friend Dual operator-(double a, const Dual& b) { return Dual(a) - b; }
+    friend Dual operator*(Dual a, double b) { a.v *= b; for (int k = 0; k < N; ++k) a.d[k] *= b; return a; }
+    friend Dual operator*(double a, Dual b) { return b * a; }
+    friend Dual operator/(Dual a, double b) { return a * (1.0 / b); }
+    friend Dual operator/(double a, const Dual& b) { return Dual(a) / b; }
+
+    friend bool operator<(const Dual& a, const Dual& b) { return a.v < b.v; }
+    friend bool operator>(const Dual& a, const Dual& b) { return a.v > b.v; }
+    friend bool operator<=(const Dual& a, const Dual& b) { return a.v <= b.v; }
+    friend bool operator>=(const Dual& a, const Dual& b) { return a.v >= b.v; }
+    friend bool operator==(const Dual& a, const Dual& b) { return a.v == b.v; }
+    friend bool operator!=(const Dual& a, const Dual& b) { return a.v != b.v; }
+    friend bool operator<(const Dual& a, double b) { return a.v < b; }
+    friend bool operator>(const Dual& a, double b) { return a.v > b; }
+    friend bool operator<=(const Dual& a, double b) { return a.v <= b; }
+    friend bool operator>=(const Dual& a, double b) { return a.v >= b; }
+    friend bool operator<(double a, const Dual& b) { return a < b.v; }
+    friend bool operator>(double a, const Dual& b) { return a > b.v; }
+};
+
+// f(a) with slope f'(a) applied to every derivative
+template <int N>
+static inline Dual<N> dual_chain(const Dual<N>& a, double f, double df) {
+    Dual<N> r(f);
+    for (int k = 0; k < N; ++k) r.d[k] = df * a.d[k];
+    return r;
+}
+
+template <int N> static inline Dual<N> exp(const Dual<N>& a) { double e = std::exp(a.v); return dual_chain(a, e, e); }
+template <int N> static inline Dual<N> log(const Dual<N>& a) { return dual_chain(a, std::log(a.v), 1.0 / a.v); }
+template <int N> static inline Dual<N> sinh(const Dual<N>& a) { return dual_chain(a, std::sinh(a.v), std::cosh(a.v)); }
+template <int N> static inline Dual<N> cosh(const Dual<N>& a) { return dual_chain(a, std::cosh(a.v), std::sinh(a.v)); }
+template <int N> static inline Dual<N> fabs(const Dual<N>& a) { return a.v < 0.0 ? -a : a; }
+template <int N> static inline Dual<N> abs(const Dual<N>& a) { return fabs(a); }
+// The slope of sqrt is unbounded at 0; a zero there keeps data-only inputs (|V| = 0) finite
+template <int N> static inline Dual<N> sqrt(const Dual<N>& a) {
+    double s = std::sqrt(a.v);
+    return dual_chain(a, s, s > 0.0 ? 0.5 / s : 0.0);
+}
+template <int N> static inline Dual<N> pow(const Dual<N>& a, double b) {
+    double p = std::pow(a.v, b);
+    return dual_chain(a, p, a.v != 0.0 ? b * p / a.v : 0.0);
+}
+template <int N> static inline Dual<N> pow(const Dual<N>& a, const Dual<N>& b) {
+    // a^b = exp(b ln a): slope b a^(b-1) da + a^b ln(a) db
+    double p = std::pow(a.v, b.v);
+    Dual<N> r(p);
+    double da = a.v != 0.0 ? b.v * p / a.v : 0.0;
+    double db = a.v > 0.0 ? p * std::log(a.v) : 0.0;
+    for (int k = 0; k < N; ++k) r.d[k] = da * a.d[k] + db * b.d[k];
+    return r;
+}
+
+// Value part of a plain or dual scalar
+static inline double value_of(double x) { return x; }
+template <int N> static inline double value_of(const Dual<N>& x) { return x.v; }
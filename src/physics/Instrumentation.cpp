@@ -0,0 +1,15 @@
+#include "Instrumentation.h"
+#include <thread>
+
+double StatsTicksPerSecond() {
+    static const double ticks_per_second = [] {
+        using Clock = std::chrono::steady_clock;
+        auto t0 = Clock::now();
+        uint64_t c0 = stats_ticks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t c1 = stats_ticks();
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        return secs > 0.0 ? (double)(c1 - c0) / secs : 1e9;
+    }();
+    return ticks_per_second;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+// Instrumentation counters, compiled in with the CMake option MEMRISTORSIM_STATS. Every hook
+// is guarded by `if constexpr (kStatsEnabled)`, so a default build carries none of them.
+#ifndef MEMRISTORSIM_STATS
+#define MEMRISTORSIM_STATS 0
+#endif
+
+constexpr bool kStatsEnabled = MEMRISTORSIM_STATS != 0;
+
+// Timestamp for phase timing: the TSC on x86, steady_clock nanoseconds elsewhere
+inline uint64_t stats_ticks() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// stats_ticks() per second, measured once against steady_clock
+double StatsTicksPerSecond();
+
+// Device-kernel events. Counted per thread, so concurrent arrays (CrossbarPool replicas) do
+// not contend; CrossbarArray attributes them to its phases by differencing around each phase.
+struct KernelCounters {
+    uint64_t current_calls = 0;         // Cell current evaluations (DeviceBank::calculate_current*, step readout)
+    uint64_t selector_solves = 0;       // Series selector / memristor voltage splits solved
+    uint64_t selector_iterations = 0;   // Safeguarded Newton iterations over those solves
+    uint64_t selector_bisections = 0;   // Iterations that fell back to bisecting the bracket
+
+    KernelCounters& operator+=(const KernelCounters& o) {
+        current_calls += o.current_calls;
+        selector_solves += o.selector_solves;
+        selector_iterations += o.selector_iterations;
+        selector_bisections += o.selector_bisections;
+        return *this;
+    }
+    KernelCounters operator-(const KernelCounters& o) const {
+        return {current_calls - o.current_calls, selector_solves - o.selector_solves,
+                selector_iterations - o.selector_iterations, selector_bisections - o.selector_bisections};
+    }
+};
+
+inline KernelCounters& kernel_counters() {
+    static thread_local KernelCounters counters;
+    return counters;
+}
+
+// Cumulative counters of one CrossbarArray since construction or reset_stats(). Phase times are
+// in stats_ticks() units; divide by StatsTicksPerSecond() for seconds.
+struct CrossbarStats {
+    uint64_t updates = 0;             // update() calls and forward_batch() samples
+
+    uint64_t dac_ticks = 0;           // Input DAC quantization
+    uint64_t solve_ticks = 0;         // Nodal solve (IR drop)
+    uint64_t device_ticks = 0;        // Device stepping, or the read of a read-only sample
+    uint64_t adc_ticks = 0;           // Column readout and ADC quantization
+
+    uint64_t gs_solves = 0;           // Gauss-Seidel solves, including Newton fallbacks
+    uint64_t gs_sweeps = 0;
+    int last_gs_sweeps = 0;
+    double last_gs_residual = 0.0;    // Largest node update of the final sweep (V)
+    bool last_gs_converged = false;   // max_diff < tolerance before the sweep limit
+
+    uint64_t newton_solves = 0;
+    uint64_t newton_iterations = 0;
+    uint64_t newton_fallbacks = 0;    // Solves that did not converge and fell back to Gauss-Seidel
+    int last_newton_iterations = 0;
+    double last_newton_residual = 0.0;   // Largest KCL mismatch in volts (|F| * r_wire)
+
+    KernelCounters solve_kernel;      // Kernel events of the nodal solve phase
+    KernelCounters device_kernel;     // Kernel events of the device phase
+};
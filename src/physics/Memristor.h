@@ -1,11 +1,17 @@
 #pragma once
+#include <cstdint>
 #include <utility>
-#include <random>
 #include <string>
 #include <map>
+#include <memory>
+#include "../utils/CounterRng.h"
 
 enum class ConductionModel { Sinh, PooleFrenkel, Schottky };
 
+// Time integration of the state variable: one fixed RK4 step per update, or an embedded
+// Runge-Kutta pair (Bogacki-Shampine 3(2), Dormand-Prince 5(4)) with error-controlled substeps
+enum class IntegratorMode { RK4, BogackiShampine, DormandPrince };
+
 struct MemristorParams {
     double v_off = 1.0;
     double v_on = -1.0;
@@ -36,6 +42,23 @@ struct MemristorParams {
     double rtn_amplitude = 0.03;     // RTN relative current fluctuation (e.g., 3%)
     double rtn_tau_c = 0.05;         // Mean capture time (s)
     double rtn_tau_e = 0.05;         // Mean emission time (s)
+
+    // Sub-threshold reads (v_on <= V <= v_off, dT <= T_critical) skip the RK4 integrator;
+    // these choose whether such reads still see C2C diffusion and RTN switching
+    bool subthreshold_c2c = true;
+    bool subthreshold_rtn = true;
+
+    bool enable_read_noise = true;   // 5% (1 SD) thermal noise on every current read
+
+    // Read cell currents from a precomputed I(V, w) table (see CurrentTable) instead of the
+    // conduction model, for |V| <= table_v_max. Trades accuracy (see CurrentTable) for speed.
+    bool tabulated_current = false;
+    double table_v_max = 3.0;
+
+    // State integration
+    IntegratorMode integrator = IntegratorMode::RK4;
+    double integrator_rtol = 1e-6;   // Relative local error tolerance on w (adaptive modes)
+    double integrator_atol = 1e-9;   // Absolute local error tolerance on w (adaptive modes)
     
     // Selector Device Parameters (1S1R / 1T1R)
     bool enable_selector = false;
@@ -46,40 +69,107 @@ struct MemristorParams {
     double selector_v_th_trans = 0.4; // 1T1R Transistor threshold voltage (V)
 };
 
-class PhysicsEngine {
+// MemristorParams whose continuous device fields are held as T, as consumed by the device
+// kernels. The derived fields hide the double ones of the base, which keeps the plain values
+// for flags and branch decisions.
+template <typename T>
+struct MemristorParamsT : MemristorParams {
+    T v_off, v_on, k_off, k_on, alpha_off, alpha_on, R_off, R_on, gamma_sinh, beta_pf, beta_sc;
+    T T_critical, I_compliance, theta_thermal, rtn_amplitude, selector_v_th, selector_v_gate, selector_v_th_trans;
+
+    MemristorParamsT() : MemristorParamsT(MemristorParams()) {}
+    explicit MemristorParamsT(const MemristorParams& p)
+        : MemristorParams(p), v_off(p.v_off), v_on(p.v_on), k_off(p.k_off), k_on(p.k_on), alpha_off(p.alpha_off),
+          alpha_on(p.alpha_on), R_off(p.R_off), R_on(p.R_on), gamma_sinh(p.gamma_sinh), beta_pf(p.beta_pf),
+          beta_sc(p.beta_sc), T_critical(p.T_critical), I_compliance(p.I_compliance), theta_thermal(p.theta_thermal),
+          rtn_amplitude(p.rtn_amplitude), selector_v_th(p.selector_v_th), selector_v_gate(p.selector_v_gate),
+          selector_v_th_trans(p.selector_v_th_trans) {}
+
+    const MemristorParams& values() const { return *this; }
+
+    // The T copy of a fittable MemristorParams field (nullptr for fields not carried as T)
+    T* field(double MemristorParams::* f) {
+        if (f == &MemristorParams::v_off) return &v_off;
+        if (f == &MemristorParams::v_on) return &v_on;
+        if (f == &MemristorParams::k_off) return &k_off;
+        if (f == &MemristorParams::k_on) return &k_on;
+        if (f == &MemristorParams::alpha_off) return &alpha_off;
+        if (f == &MemristorParams::alpha_on) return &alpha_on;
+        if (f == &MemristorParams::R_off) return &R_off;
+        if (f == &MemristorParams::R_on) return &R_on;
+        if (f == &MemristorParams::gamma_sinh) return &gamma_sinh;
+        if (f == &MemristorParams::beta_pf) return &beta_pf;
+        if (f == &MemristorParams::beta_sc) return &beta_sc;
+        return nullptr;
+    }
+};
+
+template <typename T>
+class CurrentTableT;
+
+// Single-device simulator templated on the scalar type of its state and device math.
+// PhysicsEngine (double) is the reference model; PhysicsEngineF runs the same equations in
+// float32. Time steps and write-verify energy are accumulated in double for either type.
+template <typename T>
+class PhysicsEngineT {
 public:
-    explicit PhysicsEngine(const MemristorParams& p);
+    explicit PhysicsEngineT(const MemristorParams& p);
     void reset();
-    void update(double dt, double voltage);
-    double w() const;
-    double r() const;
-    double i() const;
-    double power() const;
-    double dT() const;
-    std::pair<double,double> iv_point(double v) const;
+    // Re-key the noise streams (D2D draws on the next reset(), C2C, RTN, read noise) and
+    // restart their step counter
+    void seed(uint64_t s);
+    void update(double dt, T voltage);
+    T w() const;
+    T r() const;
+    T i() const;
+    T power() const;
+    T dT() const;
+    std::pair<T,T> iv_point(T v) const;
     MemristorParams& params();
     void set_params(const MemristorParams& p);
-    void set_w(double w);
-    double calculate_current(double voltage_diff) const;
-    double calculate_memristor_current(double voltage_diff) const;
-    double calculate_selector_current(double v_sel) const;
+    void set_w(T w);
+    T calculate_current(T voltage_diff) const;
+    T calculate_memristor_current(T voltage_diff) const;
+    T calculate_selector_current(T v_sel) const;
     std::pair<int, double> program_write_verify(double w_target, double tolerance = 0.01, int max_pulses = 30);
+    int last_substeps() const;
+    // True when the last update's adaptive integrator met a non-finite error estimate at its
+    // minimum substep and kept the last finite state (see integrate_embedded_rk)
+    bool integrator_failed() const;
 private:
     MemristorParams m_params;
-    MemristorParams m_active_params;
-    double m_w;
-    double m_r;
-    double m_i;
-    double m_power;
-    double m_dT;
+    MemristorParamsT<T> m_active_params;
+    std::shared_ptr<const CurrentTableT<T>> m_table;   // Set when m_params.tabulated_current
+    T m_w;
+    T m_r;
+    T m_i;
+    T m_power;
+    T m_dT;
     int m_rtn_state = 0;
-    std::default_random_engine m_rng;
-    std::normal_distribution<double> m_norm{0.0, 1.0};
-    double get_dw_dt(double v, double w, double dT) const;
-    double rk4(double dt, double v, double w0, double dT) const;
+    // Memristor share of the cell bias from the last series-selector solve, which warm-starts
+    // the next one (update's integrator and readout solves, and calculate_current)
+    mutable T m_v_share = T(0.5);
+    int m_alpha_on_int = -1;
+    int m_alpha_off_int = -1;
+    double m_h_adaptive = 0.0;       // Step size carried between adaptive updates
+    int m_last_substeps = 0;
+    bool m_integrator_failed = false;
+    CounterRng m_rng;                // Draws keyed by (seed, device 0, stream, step)
+    uint64_t m_step = 0;
+    T get_dw_dt(T v, T w, T dT) const;
+    T rk4(double dt, T v, T w0, T dT) const;
     void apply_d2d_variability();
+    // update() body for the DeviceKernel matching the active parameters
+    template <typename K>
+    void update_with(const K& kern, double dt, T voltage);
 };
 
+using PhysicsEngine = PhysicsEngineT<double>;
+using PhysicsEngineF = PhysicsEngineT<float>;
+
+extern template class PhysicsEngineT<double>;
+extern template class PhysicsEngineT<float>;
+
 struct MaterialPreset {
     std::string name;
     MemristorParams params;
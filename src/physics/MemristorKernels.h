@@ -0,0 +1,576 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "Memristor.h"
+#include "Dual.h"
+#include "Instrumentation.h"
+
+// Stateless VTEAM device equations shared by PhysicsEngine (one device) and DeviceBank
+// (structure-of-arrays). Everything is inline and free of per-device state so the bank can
+// run the same math across contiguous arrays and let the compiler pack it into SIMD lanes.
+//
+// The kernels are templates over the scalar type T and the parameter struct P. MemristorParams
+// with double is the reference simulator; MemristorParamsT<float> runs the same equations in
+// single precision (DeviceBankF), and MemristorParamsT<Dual<N>> carries parameter derivatives.
+// Constants are written as T(...) so a float instantiation never widens to double.
+//
+// The current, selector and conductance models live in DeviceKernel, specialized at compile
+// time on a DevicePolicy (conduction model x selector kind x RTN). with_device_kernel picks
+// the specialization at run time once, so loops over cells and solver sweeps are branch-free.
+
+template <typename T>
+static inline T clamp01(T x) { return x < T(0) ? T(0) : (x > T(1) ? T(1) : x); }
+
+// x^n for a small non-negative integer n by binary exponentiation. The trip count only
+// depends on n, so a loop over devices sharing n stays branch-uniform and vectorizes.
+template <typename T>
+static inline T pow_int(T x, int n) {
+    T result = T(1);
+    while (n > 0) {
+        if (n & 1) result *= x;
+        x *= x;
+        n >>= 1;
+    }
+    return result;
+}
+
+// x^N for a compile-time N, unrolled into N's square-and-multiply chain (x^8 is three squarings)
+template <int N, typename T>
+static inline T pow_fixed(T x) {
+    if constexpr (N == 0) {
+        return T(1);
+    } else if constexpr (N == 1) {
+        return x;
+    } else if constexpr (N % 2 == 0) {
+        T h = pow_fixed<N / 2>(x);
+        return h * h;
+    } else {
+        return pow_fixed<N - 1>(x) * x;
+    }
+}
+
+// Exponent used for the VTEAM threshold term. Integral alphas (the common 1, 3, 4 presets)
+// are returned as a non-negative int so callers can use pow_int; -1 means "use std::pow".
+static inline int integral_exponent(double alpha) {
+    if (alpha >= 0.0 && alpha <= 16.0 && alpha == std::floor(alpha)) return (int)alpha;
+    return -1;
+}
+
+template <typename T, typename A>
+static inline T threshold_pow(T x, A alpha, int alpha_int) {
+    using std::pow;
+    return alpha_int >= 0 ? pow_int(x, alpha_int) : T(pow(x, alpha));
+}
+
+template <typename P, typename T>
+static inline T memristor_dw_dt(const P& p, int alpha_on_int, int alpha_off_int,
+                                T k_on, T k_off, T v, T w, T dT) {
+    using std::abs;
+    const T one = T(1);
+    T dw = T(0);
+    w = clamp01(w);
+    if (v > p.v_off) {
+        // RESET process: trying to turn OFF (w -> 0.0)
+        // k_off is negative, so this term will be negative
+        dw = k_off * threshold_pow((v / p.v_off) - one, p.alpha_off, alpha_off_int);
+        // Biolek window for w decreasing towards 0
+        dw *= (one - pow_fixed<8>(w - one));
+    } else if (v < p.v_on) {
+        // SET process: trying to turn ON (w -> 1.0)
+        // k_on is positive, so this term will be positive
+        dw = k_on * threshold_pow((v / p.v_on) - one, p.alpha_on, alpha_on_int);
+        // Biolek window for w increasing towards 1
+        dw *= (one - pow_fixed<8>(w));
+    }
+
+    // Smooth thermal dissolution: if temperature rise exceeds T_critical,
+    // decay filament back to 0. Rate is proportional to excess temperature.
+    if (dT > p.T_critical) {
+        T thermal_decay = -abs(k_off) * ((dT - p.T_critical) / p.T_critical) * w;
+        dw += thermal_decay;
+    }
+
+    return dw;
+}
+
+// True when memristor_dw_dt is identically zero for this step: the cell bias lies between
+// both switching thresholds and the device is below the thermal dissolution point. A series
+// selector only takes a same-signed share of the bias, so the test holds for v_mem as well.
+template <typename P, typename T>
+static inline bool is_subthreshold(const P& p, T voltage, T dT) {
+    return voltage >= p.v_on && voltage <= p.v_off && p.v_on <= T(0) && p.v_off >= T(0) && dT <= p.T_critical;
+}
+
+// One classical RK4 step of the state equation at a fixed bias
+template <typename P, typename T>
+static inline T rk4_step(const P& p, int alpha_on_int, int alpha_off_int, T k_on, T k_off,
+                         T v, T w0, T dT, double dt) {
+    const T h = T(dt);
+    const T half = T(0.5 * dt);
+    T k1 = memristor_dw_dt(p, alpha_on_int, alpha_off_int, k_on, k_off, v, w0, dT);
+    T k2 = memristor_dw_dt(p, alpha_on_int, alpha_off_int, k_on, k_off, v, w0 + half * k1, dT);
+    T k3 = memristor_dw_dt(p, alpha_on_int, alpha_off_int, k_on, k_off, v, w0 + half * k2, dT);
+    T k4 = memristor_dw_dt(p, alpha_on_int, alpha_off_int, k_on, k_off, v, w0 + h * k3, dT);
+    return w0 + T(dt / 6.0) * (k1 + T(2) * k2 + T(2) * k3 + k4);
+}
+
+// Integrates the autonomous ODE dw/dt = f(w) across [0, dt] with an embedded Runge-Kutta pair
+// (FSAL form) and local error control: a substep is accepted when |err| <= atol + rtol * |w|,
+// and the step size then grows or shrinks with the usual 0.9 * err^(-1/(q+1)) rule. Flat stretches
+// are crossed in one substep while switching events are resolved finely. `h` carries the step
+// size between calls (<= 0 starts from dt); `substeps` receives the accepted substep count.
+// A non-finite error estimate (NaN or inf in a stage) rejects the substep and halves it; once
+// that reaches dt * 1e-9 the integration stops at the last accepted state, sets `failed` and
+// clears `h`, instead of accepting the bad substep.
+// The state and stages are T (Dual<N> included); time and step-size control stay in double.
+template <typename T, typename F>
+static inline T integrate_embedded_rk(IntegratorMode mode, F&& f, T w0, double dt,
+                                      double rtol, double atol, double& h, int& substeps, bool& failed) {
+    // Bogacki-Shampine 3(2): rows of A, the last row doubles as the propagated solution
+    static constexpr double bs_a[4][6] = {
+        {0.0},
+        {1.0 / 2.0},
+        {0.0, 3.0 / 4.0},
+        {2.0 / 9.0, 1.0 / 3.0, 4.0 / 9.0}};
+    static constexpr double bs_e[7] = {-5.0 / 72.0, 1.0 / 12.0, 1.0 / 9.0, -1.0 / 8.0};
+    // Dormand-Prince 5(4)
+    static constexpr double dp_a[7][6] = {
+        {0.0},
+        {1.0 / 5.0},
+        {3.0 / 40.0, 9.0 / 40.0},
+        {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0},
+        {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0},
+        {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0},
+        {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0}};
+    static constexpr double dp_e[7] = {71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0,
+                                       -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0};
+
+    const bool dp = (mode == IntegratorMode::DormandPrince);
+    const int stages = dp ? 7 : 4;
+    const double (*a)[6] = dp ? dp_a : bs_a;
+    const double* e = dp ? dp_e : bs_e;
+    const double exponent = dp ? -1.0 / 5.0 : -1.0 / 3.0;
+    const double h_min = dt * 1e-9;
+
+    substeps = 0;
+    failed = false;
+    if (h <= 0.0 || h > dt) h = dt;
+
+    T k[7];
+    T w = w0;
+    double t = 0.0;
+    k[0] = f(w);
+    while (t < dt) {
+        double remaining = dt - t;
+        double step = std::min(h, remaining);
+
+        T w_new = w;
+        for (int s = 1; s < stages; ++s) {
+            T acc = T(0);
+            for (int j = 0; j < s; ++j) acc += T(a[s][j]) * k[j];
+            T w_stage = w + T(step) * acc;
+            k[s] = f(w_stage);
+            if (s == stages - 1) w_new = w_stage;
+        }
+
+        T err_sum = T(0);
+        for (int s = 0; s < stages; ++s) err_sum += T(e[s]) * k[s];
+        double err = std::fabs(step * value_of(err_sum)) /
+                     (atol + rtol * std::max(std::fabs(value_of(w)), std::fabs(value_of(w_new))));
+
+        if (!std::isfinite(err)) {
+            if (step <= h_min) {
+                failed = true;
+                h = 0.0;
+                return w;
+            }
+            h = std::max(h_min, 0.5 * step);
+            continue;
+        }
+
+        double factor = (err > 0.0) ? 0.9 * std::pow(err, exponent) : 5.0;
+        factor = std::min(5.0, std::max(0.2, factor));
+        if (err <= 1.0 || step <= h_min) {
+            t = (step >= remaining) ? dt : t + step;
+            w = w_new;
+            k[0] = k[stages - 1];
+            ++substeps;
+            // A step clipped to the end of the interval says nothing about the next one
+            if (step < h) h = std::max(h, step * factor);
+            else h = step * factor;
+        } else {
+            h = std::max(h_min, step * factor);
+        }
+    }
+    return w;
+}
+
+// Series selector in front of the memristor, resolved from enable_selector / selector_type
+enum class SelectorKind { None, Threshold, Transistor };
+
+// Compile-time device configuration. A DeviceKernel specialized on it carries no branches on
+// the conduction model, the selector or RTN, so the inner solver loops run straight-line math.
+template <ConductionModel CM, SelectorKind SK, bool RTN>
+struct DevicePolicy {
+    static constexpr ConductionModel conduction = CM;
+    static constexpr SelectorKind selector = SK;
+    static constexpr bool rtn = RTN;
+};
+
+// Per-parameter-set constants of the conduction and selector models, computed once instead
+// of on every current evaluation (sinh(gamma) alone is a transcendental per call otherwise).
+template <typename T>
+struct DeviceConstants {
+    T r_on, r_off;
+    T gamma;             // Sinh model nonlinearity
+    T sinh_denom;        // R_off * sinh(gamma)
+    T beta_pf, beta_sc;
+    T rtn_gain[2];       // RTN current factor with the trap empty / filled
+    T i_compliance;
+    T sel_v_th;          // 1S1R threshold voltage
+    T sel_v_overdrive;   // 1T1R V_gate - V_th
+
+    DeviceConstants() = default;
+    template <typename P>
+    explicit DeviceConstants(const P& p)
+        : r_on(p.R_on), r_off(p.R_off), gamma(p.gamma_sinh), sinh_denom(T(1)), beta_pf(p.beta_pf),
+          beta_sc(p.beta_sc), i_compliance(p.I_compliance), sel_v_th(p.selector_v_th),
+          sel_v_overdrive(T(p.selector_v_gate) - T(p.selector_v_th_trans)) {
+        using std::sinh;
+        if (p.conduction_model == ConductionModel::Sinh) sinh_denom = r_off * sinh(gamma);
+        rtn_gain[0] = T(1) + T(-0.5) * T(p.rtn_amplitude);
+        rtn_gain[1] = T(1) + T(0.5) * T(p.rtn_amplitude);
+    }
+};
+
+// Cell current, series split and small-signal conductances of one parameter set, specialized
+// on a DevicePolicy. Obtained through with_device_kernel, which dispatches once per call site
+// (e.g. once per array update) rather than once per device evaluation.
+template <class Policy, typename T>
+struct DeviceKernel {
+    using policy = Policy;
+    using scalar = T;
+    DeviceConstants<T> c;
+
+    T memristor_current(T w, int rtn_state, T voltage_diff) const {
+        using std::exp;
+        using std::fabs;
+        using std::sinh;
+        using std::sqrt;
+
+        // Calculate current using a highly realistic nonlinear conduction model
+        // Ohmic in ON state (w=1), and selectable nonlinear in OFF state (w=0)
+        const T one = T(1);
+        T i_on = voltage_diff / c.r_on;
+        T i_off;
+        if constexpr (Policy::conduction == ConductionModel::Sinh) {
+            i_off = sinh(c.gamma * voltage_diff) / c.sinh_denom;
+        } else if constexpr (Policy::conduction == ConductionModel::PooleFrenkel) {
+            // Poole-Frenkel Emission: ln(I/V) is proportional to sqrt(V)
+            i_off = (voltage_diff / c.r_off) * exp(c.beta_pf * (sqrt(fabs(voltage_diff)) - one));
+        } else {
+            // Schottky Tunneling / Emission: ln(I) is proportional to sqrt(V)
+            T sgn_v = (voltage_diff > T(0)) ? one : ((voltage_diff < T(0)) ? -one : T(0));
+            i_off = (sgn_v / c.r_off) * exp(c.beta_sc * (sqrt(fabs(voltage_diff)) - one));
+        }
+
+        T raw_i = w * i_on + (one - w) * i_off;
+
+        // RTN Simulation relative current fluctuation
+        if constexpr (Policy::rtn) {
+            raw_i *= c.rtn_gain[rtn_state == 1 ? 1 : 0];
+        }
+
+        // Enforce current compliance limit
+        if (raw_i > c.i_compliance) raw_i = c.i_compliance;
+        if (raw_i < -c.i_compliance) raw_i = -c.i_compliance;
+
+        return raw_i;
+    }
+
+    T selector_current(T v_sel) const {
+        using std::exp;
+        using std::fabs;
+        T abs_v = fabs(v_sel);
+
+        if constexpr (Policy::selector == SelectorKind::Transistor) {
+            // 1T1R Transistor Selector Model (Square-law MOSFET model)
+            T beta = T(2.0e-3); // Transconductance beta (A/V^2)
+            T v_overdrive = c.sel_v_overdrive;
+            if (v_overdrive <= T(0)) return T(0);
+
+            T sgn_v = (v_sel > T(0)) ? T(1) : ((v_sel < T(0)) ? T(-1) : T(0));
+            if (abs_v < v_overdrive) {
+                // Linear region
+                return sgn_v * beta * (v_overdrive * abs_v - T(0.5) * abs_v * abs_v);
+            } else {
+                // Saturation region
+                return sgn_v * T(0.5) * beta * v_overdrive * v_overdrive;
+            }
+        } else {
+            // 1S1R Volatile Threshold Switch Model
+            // G_off is 1e-9 S (1 GOhm) to eliminate leakage, G_on is 1e-3 S (1 kOhm)
+            T g_off = T(1e-9);
+            T g_on = T(1e-3);
+
+            // Smooth transition representing volatile threshold switching
+            T conduct = g_off + (g_on - g_off) / (T(1) + exp(- (abs_v - c.sel_v_th) / T(0.05)));
+            return v_sel * conduct;
+        }
+    }
+
+    // Voltage across the memristor when a series selector shares the total cell bias
+    // (V_total = V_sel + V_mem, I_sel = I_mem). The residual i_mem(v) - i_sel(V - v) rises
+    // monotonically on [0, V] (or [V, 0]), so Newton steps are kept inside a bracket that every
+    // residual sign narrows, with bisection whenever a step would leave it. `share` is the
+    // memristor's fraction V_mem / V_total: it seeds the solve and receives the result, so a
+    // caller that keeps it per device warm-starts the next solve (typically 2-3 evaluations
+    // instead of the 12 of the former bisection, which only resolved V_mem to V / 8192).
+    T series_v_mem(T w, int rtn_state, T voltage, T& share) const {
+        if constexpr (Policy::selector == SelectorKind::None) {
+            return voltage;
+        } else {
+            using std::fabs;
+            if (voltage == T(0)) return T(0);
+            T low = (voltage > T(0)) ? T(0) : voltage;
+            T high = (voltage > T(0)) ? voltage : T(0);
+            const T tol = fabs(voltage) * T(64) * std::numeric_limits<T>::epsilon();
+            T v = (share > T(0) && share < T(1)) ? share * voltage : T(0.5) * voltage;
+            if constexpr (kStatsEnabled) ++kernel_counters().selector_solves;
+            for (int iter = 0; iter < 40; ++iter) {
+                if constexpr (kStatsEnabled) ++kernel_counters().selector_iterations;
+                T g_mem = T(0), g_sel = T(0);
+                T f = memristor_current_and_slope(w, rtn_state, v, g_mem) -
+                      selector_current_and_slope(voltage - v, g_sel);
+                if (f == T(0)) break;
+                if (f > T(0)) {
+                    high = v;
+                } else {
+                    low = v;
+                }
+                T slope = g_mem + g_sel;
+                T next = (slope > T(0)) ? v - f / slope : (low + high) * T(0.5);
+                if (!(next > low && next < high)) {
+                    next = (low + high) * T(0.5);
+                    if constexpr (kStatsEnabled) ++kernel_counters().selector_bisections;
+                }
+                bool done = fabs(next - v) <= tol || high - low <= tol;
+                v = next;
+                if (done) break;
+            }
+            share = v / voltage;
+            return v;
+        }
+    }
+
+    // Cold-start split, for one-off evaluations without a cached share
+    T series_v_mem(T w, int rtn_state, T voltage) const {
+        T share = T(0.5);
+        return series_v_mem(w, rtn_state, voltage, share);
+    }
+
+    T cell_current(T w, int rtn_state, T voltage_diff, T& share) const {
+        return memristor_current(w, rtn_state, series_v_mem(w, rtn_state, voltage_diff, share));
+    }
+
+    T cell_current(T w, int rtn_state, T voltage_diff) const {
+        return memristor_current(w, rtn_state, series_v_mem(w, rtn_state, voltage_diff));
+    }
+
+    // Small-signal conductance dI/dV of memristor_current, used to linearize the nodal system.
+    T memristor_conductance(T w, int rtn_state, T voltage_diff) const {
+        using std::cosh;
+        using std::exp;
+        using std::fabs;
+        using std::sqrt;
+        const T one = T(1);
+        T abs_v = fabs(voltage_diff);
+
+        T g_on = one / c.r_on;
+        T g_off;
+        if constexpr (Policy::conduction == ConductionModel::Sinh) {
+            g_off = c.gamma * cosh(c.gamma * voltage_diff) / c.sinh_denom;
+        } else if constexpr (Policy::conduction == ConductionModel::PooleFrenkel) {
+            T sqrt_v = sqrt(abs_v);
+            g_off = exp(c.beta_pf * (sqrt_v - one)) * (one + T(0.5) * c.beta_pf * sqrt_v) / c.r_off;
+        } else {
+            // The sgn(V) prefactor makes the model singular at 0 V; regularize the slope there
+            T sqrt_v = sqrt(abs_v > T(1e-6) ? abs_v : T(1e-6));
+            g_off = exp(c.beta_sc * (sqrt_v - one)) * c.beta_sc / (T(2) * sqrt_v * c.r_off);
+        }
+
+        T g = w * g_on + (one - w) * g_off;
+        if constexpr (Policy::rtn) {
+            g *= c.rtn_gain[rtn_state == 1 ? 1 : 0];
+        }
+
+        // Inside compliance the current is pinned and no longer responds to V
+        T raw_i = memristor_current(w, rtn_state, voltage_diff);
+        if (fabs(raw_i) >= c.i_compliance) return T(0);
+        return g;
+    }
+
+    T selector_conductance(T v_sel) const {
+        using std::exp;
+        using std::fabs;
+        T abs_v = fabs(v_sel);
+        if constexpr (Policy::selector == SelectorKind::Transistor) {
+            T beta = T(2.0e-3);
+            T v_overdrive = c.sel_v_overdrive;
+            if (v_overdrive <= T(0) || abs_v >= v_overdrive) return T(0);
+            return beta * (v_overdrive - abs_v);
+        } else {
+            T g_off = T(1e-9);
+            T g_on = T(1e-3);
+            T sig = T(1) / (T(1) + exp(- (abs_v - c.sel_v_th) / T(0.05)));
+            T conduct = g_off + (g_on - g_off) * sig;
+            return conduct + abs_v * (g_on - g_off) * sig * (T(1) - sig) / T(0.05);
+        }
+    }
+
+    // Cell current together with its total small-signal conductance. With a series selector the
+    // two devices combine like resistors: 1/g = 1/g_mem + 1/g_sel.
+    T cell_current_and_conductance(T w, int rtn_state, T voltage_diff, T& g_cell, T& share) const {
+        T v_mem = series_v_mem(w, rtn_state, voltage_diff, share);
+        T g_mem = memristor_conductance(w, rtn_state, v_mem);
+        if constexpr (Policy::selector != SelectorKind::None) {
+            T g_sel = selector_conductance(voltage_diff - v_mem);
+            g_cell = (g_mem + g_sel > T(0)) ? (g_mem * g_sel) / (g_mem + g_sel) : T(0);
+        } else {
+            g_cell = g_mem;
+        }
+        return memristor_current(w, rtn_state, v_mem);
+    }
+
+    T cell_current_and_conductance(T w, int rtn_state, T voltage_diff, T& g_cell) const {
+        T share = T(0.5);
+        return cell_current_and_conductance(w, rtn_state, voltage_diff, g_cell, share);
+    }
+
+private:
+    // Current and slope for the series solve, sharing the transcendental work. The slope only
+    // steers the Newton step, so it skips the compliance bookkeeping of memristor_conductance
+    // beyond zeroing it where the current is pinned.
+    T memristor_current_and_slope(T w, int rtn_state, T voltage_diff, T& g) const {
+        using std::cosh;
+        using std::exp;
+        using std::fabs;
+        using std::sinh;
+        using std::sqrt;
+        const T one = T(1);
+        T i_off, g_off;
+        if constexpr (Policy::conduction == ConductionModel::Sinh) {
+            T x = c.gamma * voltage_diff;
+            i_off = sinh(x) / c.sinh_denom;
+            g_off = c.gamma * cosh(x) / c.sinh_denom;
+        } else if constexpr (Policy::conduction == ConductionModel::PooleFrenkel) {
+            T sqrt_v = sqrt(fabs(voltage_diff));
+            T e = exp(c.beta_pf * (sqrt_v - one)) / c.r_off;
+            i_off = voltage_diff * e;
+            g_off = e * (one + T(0.5) * c.beta_pf * sqrt_v);
+        } else {
+            T abs_v = fabs(voltage_diff);
+            T sgn_v = (voltage_diff > T(0)) ? one : ((voltage_diff < T(0)) ? -one : T(0));
+            T sqrt_v = sqrt(abs_v > T(1e-6) ? abs_v : T(1e-6));
+            T e = exp(c.beta_sc * (sqrt(abs_v) - one)) / c.r_off;
+            i_off = sgn_v * e;
+            g_off = e * c.beta_sc / (T(2) * sqrt_v);
+        }
+        T raw_i = w * (voltage_diff / c.r_on) + (one - w) * i_off;
+        g = w / c.r_on + (one - w) * g_off;
+        if constexpr (Policy::rtn) {
+            T gain = c.rtn_gain[rtn_state == 1 ? 1 : 0];
+            raw_i *= gain;
+            g *= gain;
+        }
+        if (raw_i > c.i_compliance) { raw_i = c.i_compliance; g = T(0); }
+        if (raw_i < -c.i_compliance) { raw_i = -c.i_compliance; g = T(0); }
+        return raw_i;
+    }
+
+    T selector_current_and_slope(T v_sel, T& g) const {
+        using std::exp;
+        using std::fabs;
+        T abs_v = fabs(v_sel);
+        if constexpr (Policy::selector == SelectorKind::Transistor) {
+            T beta = T(2.0e-3);
+            T v_overdrive = c.sel_v_overdrive;
+            g = T(0);
+            if (v_overdrive <= T(0)) return T(0);
+            T sgn_v = (v_sel > T(0)) ? T(1) : ((v_sel < T(0)) ? T(-1) : T(0));
+            if (abs_v < v_overdrive) {
+                g = beta * (v_overdrive - abs_v);
+                return sgn_v * beta * (v_overdrive * abs_v - T(0.5) * abs_v * abs_v);
+            }
+            return sgn_v * T(0.5) * beta * v_overdrive * v_overdrive;
+        } else {
+            T g_off = T(1e-9);
+            T g_on = T(1e-3);
+            T sig = T(1) / (T(1) + exp(- (abs_v - c.sel_v_th) / T(0.05)));
+            T conduct = g_off + (g_on - g_off) * sig;
+            g = conduct + abs_v * (g_on - g_off) * sig * (T(1) - sig) / T(0.05);
+            return v_sel * conduct;
+        }
+    }
+};
+
+template <ConductionModel CM, SelectorKind SK, typename T, typename P, typename F>
+static inline decltype(auto) with_device_kernel_rtn(const P& p, const DeviceConstants<T>& c, F&& f) {
+    if (p.enable_rtn) return f(DeviceKernel<DevicePolicy<CM, SK, true>, T>{c});
+    return f(DeviceKernel<DevicePolicy<CM, SK, false>, T>{c});
+}
+
+template <ConductionModel CM, typename T, typename P, typename F>
+static inline decltype(auto) with_device_kernel_selector(const P& p, const DeviceConstants<T>& c, F&& f) {
+    if (!p.enable_selector) return with_device_kernel_rtn<CM, SelectorKind::None>(p, c, f);
+    if (p.selector_type == 0) return with_device_kernel_rtn<CM, SelectorKind::Threshold>(p, c, f);
+    return with_device_kernel_rtn<CM, SelectorKind::Transistor>(p, c, f);
+}
+
+// Calls f(kernel) with the DeviceKernel specialized for p's conduction model, selector and RTN
+// flag. `c` must be DeviceConstants<T>(p); callers that evaluate many devices keep it cached.
+template <typename T, typename P, typename F>
+static inline decltype(auto) with_device_kernel(const P& p, const DeviceConstants<T>& c, F&& f) {
+    switch (p.conduction_model) {
+    case ConductionModel::PooleFrenkel:
+        return with_device_kernel_selector<ConductionModel::PooleFrenkel>(p, c, f);
+    case ConductionModel::Schottky:
+        return with_device_kernel_selector<ConductionModel::Schottky>(p, c, f);
+    default:
+        return with_device_kernel_selector<ConductionModel::Sinh>(p, c, f);
+    }
+}
+
+// Single-evaluation forms: dispatch on p for one call. Loops over devices should take the
+// kernel from with_device_kernel once and call its members instead.
+template <typename P, typename T>
+static inline T memristor_current(const P& p, T w, int rtn_state, T voltage_diff) {
+    return with_device_kernel(p, DeviceConstants<T>(p),
+                              [&](const auto& k) { return k.memristor_current(w, rtn_state, voltage_diff); });
+}
+
+template <typename P, typename T>
+static inline T selector_current(const P& p, T v_sel) {
+    return with_device_kernel(p, DeviceConstants<T>(p), [&](const auto& k) { return k.selector_current(v_sel); });
+}
+
+template <typename P, typename T>
+static inline T series_v_mem(const P& p, T w, int rtn_state, T voltage) {
+    if (!p.enable_selector) return voltage;
+    return with_device_kernel(p, DeviceConstants<T>(p),
+                              [&](const auto& k) { return k.series_v_mem(w, rtn_state, voltage); });
+}
+
+template <typename P, typename T>
+static inline T cell_current(const P& p, T w, int rtn_state, T voltage_diff) {
+    return with_device_kernel(p, DeviceConstants<T>(p),
+                              [&](const auto& k) { return k.cell_current(w, rtn_state, voltage_diff); });
+}
+
+template <typename P, typename T>
+static inline T cell_current_and_conductance(const P& p, T w, int rtn_state, T voltage_diff, T& g_cell) {
+    return with_device_kernel(p, DeviceConstants<T>(p), [&](const auto& k) {
+        return k.cell_current_and_conductance(w, rtn_state, voltage_diff, g_cell);
+    });
+}
@@ -0,0 +1,210 @@
+#include "MonteCarloEnsemble.h"
+#include "MemristorKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Resolution of the per-point w histograms used for the trajectory percentiles
+static constexpr size_t kHistogramBins = 200;
+
+// Linear interpolation between order statistics of a sorted sample
+static double sorted_percentile(const std::vector<double>& sorted, double q) {
+    double pos = q * (double)(sorted.size() - 1);
+    size_t lo = (size_t)pos;
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - (double)lo);
+}
+
+// Percentile of a histogram over [0, 1], interpolated inside the bin holding the rank
+static double histogram_percentile(const uint32_t* counts, size_t total, double q) {
+    double rank = q * (double)total;
+    double below = 0.0;
+    for (size_t b = 0; b < kHistogramBins; ++b) {
+        double c = (double)counts[b];
+        if (c > 0.0 && below + c >= rank) {
+            return ((double)b + (rank - below) / c) / (double)kHistogramBins;
+        }
+        below += c;
+    }
+    return 1.0;
+}
+
+MonteCarloEnsemble::MonteCarloEnsemble(size_t workers) : m_pool(workers) {}
+
+EnsembleSummary MonteCarloEnsemble::Summarize(std::vector<double> values) {
+    values.erase(std::remove_if(values.begin(), values.end(), [](double x) { return !std::isfinite(x); }),
+                 values.end());
+    EnsembleSummary s;
+    s.count = values.size();
+    if (values.empty()) {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        s.mean = s.stddev = s.min = s.p05 = s.p50 = s.p95 = s.max = nan;
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+
+    double sum = 0.0;
+    for (double x : values) sum += x;
+    s.mean = sum / (double)values.size();
+    double ss = 0.0;
+    for (double x : values) ss += (x - s.mean) * (x - s.mean);
+    s.stddev = std::sqrt(ss / (double)values.size());
+
+    s.min = values.front();
+    s.max = values.back();
+    s.p05 = sorted_percentile(values, 0.05);
+    s.p50 = sorted_percentile(values, 0.50);
+    s.p95 = sorted_percentile(values, 0.95);
+    return s;
+}
+
+DeviceEnsembleResult MonteCarloEnsemble::run_devices(const MemristorParams& params, const WaveformGenerator& waveform,
+                                                     const EnsembleConfig& config) {
+    DeviceEnsembleResult result;
+    const size_t n = config.instances;
+    if (n == 0 || config.dt <= 0.0 || config.duration <= 0.0) return result;
+
+    const double dt = config.dt;
+    const long long steps = std::max(1LL, (long long)(config.duration / dt));
+    const long long every = std::clamp<long long>((long long)config.record_every, 1, steps);
+    const size_t points = (size_t)(steps / every);
+    const double thr = config.switch_threshold;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    for (size_t k = 0; k < points; ++k) {
+        double t = (double)((long long)(k + 1) * every) * dt;
+        result.time.push_back(t);
+        result.voltage.push_back(waveform.get_voltage(t));
+    }
+    result.final_w.assign(n, 0.0);
+    result.v_set.assign(n, nan);
+    result.v_reset.assign(n, nan);
+
+    // Instance blocks are the unit of work. Their size depends only on the instance count, so
+    // the blockwise sums (and their in-order reduction below) do not change with the thread count.
+    const size_t block = std::max<size_t>(256, (n + 1023) / 1024);
+    const size_t blocks = (n + block - 1) / block;
+    std::vector<double> block_sums(blocks * points * 4, 0.0);  // [block][point][sum w, w^2, i, i^2]
+    std::vector<std::vector<uint32_t>> hist(m_pool.size(), std::vector<uint32_t>(points * kHistogramBins, 0));
+    std::vector<PhysicsEngine> engines(m_pool.size(), PhysicsEngine(params));
+
+    m_pool.parallel_for(blocks, [&](size_t blk, size_t worker) {
+        PhysicsEngine& engine = engines[worker];
+        uint32_t* h = hist[worker].data();
+        double* sums = &block_sums[blk * points * 4];
+        size_t end = std::min(n, (blk + 1) * block);
+
+        for (size_t inst = blk * block; inst < end; ++inst) {
+            engine.seed(mix_seed(config.seed, inst));
+            engine.reset();
+            double prev_w = engine.w();
+            double v_set = nan;
+            double v_reset = nan;
+
+            for (long long s = 1; s <= steps; ++s) {
+                double v = waveform.get_voltage((double)s * dt);
+                engine.update(dt, v);
+                double w = engine.w();
+                if (std::isnan(v_set) && prev_w < thr && w >= thr) v_set = v;
+                if (std::isnan(v_reset) && prev_w >= thr && w < thr) v_reset = v;
+                prev_w = w;
+
+                if (s % every == 0) {
+                    size_t k = (size_t)(s / every) - 1;
+                    double i = engine.i();
+                    double* acc = sums + k * 4;
+                    acc[0] += w;
+                    acc[1] += w * w;
+                    acc[2] += i;
+                    acc[3] += i * i;
+                    size_t bin = std::min(kHistogramBins - 1, (size_t)(clamp01(w) * (double)kHistogramBins));
+                    ++h[k * kHistogramBins + bin];
+                }
+            }
+            result.final_w[inst] = prev_w;
+            result.v_set[inst] = v_set;
+            result.v_reset[inst] = v_reset;
+        }
+    });
+
+    // Trajectory statistics
+    result.w_mean.resize(points);
+    result.w_std.resize(points);
+    result.i_mean.resize(points);
+    result.i_std.resize(points);
+    result.w_p05.resize(points);
+    result.w_p50.resize(points);
+    result.w_p95.resize(points);
+    std::vector<uint32_t> merged(kHistogramBins);
+    for (size_t k = 0; k < points; ++k) {
+        double acc[4] = {0.0, 0.0, 0.0, 0.0};
+        for (size_t blk = 0; blk < blocks; ++blk) {
+            for (int c = 0; c < 4; ++c) acc[c] += block_sums[(blk * points + k) * 4 + c];
+        }
+        double wm = acc[0] / (double)n;
+        double im = acc[2] / (double)n;
+        result.w_mean[k] = wm;
+        result.w_std[k] = std::sqrt(std::max(0.0, acc[1] / (double)n - wm * wm));
+        result.i_mean[k] = im;
+        result.i_std[k] = std::sqrt(std::max(0.0, acc[3] / (double)n - im * im));
+
+        std::fill(merged.begin(), merged.end(), 0);
+        for (const auto& hw : hist) {
+            for (size_t b = 0; b < kHistogramBins; ++b) merged[b] += hw[k * kHistogramBins + b];
+        }
+        result.w_p05[k] = histogram_percentile(merged.data(), n, 0.05);
+        result.w_p50[k] = histogram_percentile(merged.data(), n, 0.50);
+        result.w_p95[k] = histogram_percentile(merged.data(), n, 0.95);
+    }
+
+    // Per-instance distributions
+    result.final_w_stats = Summarize(result.final_w);
+    result.v_set_stats = Summarize(result.v_set);
+    result.v_reset_stats = Summarize(result.v_reset);
+    result.set_yield = (double)result.v_set_stats.count / (double)n;
+    result.reset_yield = (double)result.v_reset_stats.count / (double)n;
+    return result;
+}
+
+CrossbarEnsembleResult MonteCarloEnsemble::run_crossbars(const CrossbarArray& prototype, const double* weights,
+                                                         const WaveformGenerator& waveform,
+                                                         const EnsembleConfig& config) {
+    CrossbarEnsembleResult result;
+    const size_t n = config.instances;
+    const size_t rows = (size_t)prototype.rows();
+    const size_t cols = (size_t)prototype.cols();
+    result.cols = cols;
+    if (n == 0 || config.dt <= 0.0 || config.duration <= 0.0) return result;
+
+    const double dt = config.dt;
+    const long long steps = std::max(1LL, (long long)(config.duration / dt));
+    result.final_outputs.assign(n * cols, 0.0);
+
+    std::vector<CrossbarArray> replicas(m_pool.size(), prototype);
+    std::vector<std::vector<double>> x(m_pool.size(), std::vector<double>(rows));
+
+    // Same blocking heuristic as CrossbarPool: small arrays are handed out several at a time
+    size_t grain = std::max<size_t>(1, 4096 / (rows * cols));
+    grain = std::min(grain, std::max<size_t>(1, n / (4 * m_pool.size())));
+
+    m_pool.parallel_for(n, [&](size_t inst, size_t worker) {
+        CrossbarArray& xbar = replicas[worker];
+        std::vector<double>& xv = x[worker];
+        xbar.seed(mix_seed(config.seed, inst));
+        xbar.reset();
+        if (weights) xbar.program_matrix(weights);
+
+        double* y = &result.final_outputs[inst * cols];
+        for (long long s = 1; s <= steps; ++s) {
+            std::fill(xv.begin(), xv.end(), waveform.get_voltage((double)s * dt));
+            xbar.forward_batch(xv.data(), 1, y, dt, false);
+        }
+    }, grain);
+
+    std::vector<double> column(n);
+    for (size_t j = 0; j < cols; ++j) {
+        for (size_t inst = 0; inst < n; ++inst) column[inst] = result.final_outputs[inst * cols + j];
+        result.column_stats.push_back(Summarize(column));
+    }
+    return result;
+}
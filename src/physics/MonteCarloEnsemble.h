@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Memristor.h"
+#include "Crossbar.h"
+#include "../utils/Waveform.h"
+#include "../utils/ThreadPool.h"
+
+struct EnsembleConfig {
+    size_t instances = 1000;
+    double duration = 1.0;           // Seconds of waveform per instance
+    double dt = 1e-3;
+    size_t record_every = 10;        // Steps between recorded trajectory points
+    double switch_threshold = 0.5;   // w level whose crossing counts as a SET / RESET event
+    uint64_t seed = 1;               // Instance n draws from the stream mix_seed(seed, n)
+};
+
+// Mean / spread / percentiles of one scalar across the ensemble (NaN entries are skipped)
+struct EnsembleSummary {
+    size_t count = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double p05 = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+struct DeviceEnsembleResult {
+    // Trajectory, one entry per recorded point
+    std::vector<double> time;
+    std::vector<double> voltage;
+    std::vector<double> w_mean, w_std, w_p05, w_p50, w_p95;
+    std::vector<double> i_mean, i_std;
+
+    // One entry per instance; v_set / v_reset are NaN for instances that never switched
+    std::vector<double> final_w;
+    std::vector<double> v_set;
+    std::vector<double> v_reset;
+
+    EnsembleSummary final_w_stats;
+    EnsembleSummary v_set_stats;
+    EnsembleSummary v_reset_stats;
+    double set_yield = 0.0;    // Fraction of instances that crossed the threshold upwards
+    double reset_yield = 0.0;  // Fraction that crossed it downwards, whether or not they had set first
+};
+
+struct CrossbarEnsembleResult {
+    size_t cols = 0;
+    std::vector<double> final_outputs;          // instances x cols bitline currents at the last step
+    std::vector<EnsembleSummary> column_stats;  // One per bitline
+};
+
+// Runs N independent copies of a device (or a whole crossbar) under one waveform, spread over
+// a ThreadPool. Every instance reseeds its engine from mix_seed(seed, n) and redraws its D2D
+// variability, so the ensemble is reproducible and independent of the worker count.
+//
+// Nothing per-step is kept per instance: trajectory means are accumulated in fixed-size
+// instance blocks (reduced in block order, so they are bit-identical for any thread count)
+// and trajectory percentiles of w come from per-worker histograms over [0, 1]. Memory is
+// O(instances + recorded points), which keeps 10^5 - 10^6 instance yield studies in RAM.
+class MonteCarloEnsemble {
+public:
+    explicit MonteCarloEnsemble(size_t workers = 0);
+
+    size_t workers() const { return m_pool.size(); }
+
+    DeviceEnsembleResult run_devices(const MemristorParams& params, const WaveformGenerator& waveform,
+                                     const EnsembleConfig& config);
+
+    // Every instance gets prototype's settings, fresh D2D draws and the row-major rows x cols
+    // weights (nullptr keeps the w_init spread); all word lines follow the waveform.
+    CrossbarEnsembleResult run_crossbars(const CrossbarArray& prototype, const double* weights,
+                                         const WaveformGenerator& waveform, const EnsembleConfig& config);
+
+    static EnsembleSummary Summarize(std::vector<double> values);
+
+private:
+    ThreadPool m_pool;
+};
@@ -0,0 +1,291 @@
+#include "NodalSolver.h"
+#include "DeviceBank.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+void SparseCholesky::analyze(int n, const std::vector<int>& Ap, const std::vector<int>& Ai) {
+    m_n = n;
+    m_Ap = Ap;
+    m_Ai = Ai;
+    m_parent.assign(n, -1);
+    m_stack.assign(n, 0);
+    m_flag.assign(n, -1);
+    m_x.assign(n, 0.0);
+
+    // Elimination tree of the upper-triangular pattern (path compression via m_next)
+    m_next.assign(n, -1);
+    for (int k = 0; k < n; ++k) {
+        for (int p = m_Ap[k]; p < m_Ap[k + 1]; ++p) {
+            int i = m_Ai[p];
+            while (i != -1 && i < k) {
+                int inext = m_next[i];
+                m_next[i] = k;
+                if (inext == -1) m_parent[i] = k;
+                i = inext;
+            }
+        }
+    }
+
+    // Column counts of L from the row patterns (each row k of L is an etree reach)
+    std::vector<int> counts(n, 1);
+    std::fill(m_flag.begin(), m_flag.end(), -1);
+    for (int k = 0; k < n; ++k) {
+        int top = ereach(k);
+        for (int t = top; t < n; ++t) counts[m_stack[t]]++;
+    }
+    m_Lp.assign(n + 1, 0);
+    for (int k = 0; k < n; ++k) m_Lp[k + 1] = m_Lp[k] + counts[k];
+    m_Li.assign(m_Lp[n], 0);
+    m_Lx.assign(m_Lp[n], 0.0);
+}
+
+int SparseCholesky::ereach(int k) {
+    int top = m_n;
+    m_flag[k] = k;
+    for (int p = m_Ap[k]; p < m_Ap[k + 1]; ++p) {
+        int i = m_Ai[p];
+        if (i > k) continue;
+        int len = 0;
+        for (; m_flag[i] != k; i = m_parent[i]) {
+            m_stack[len++] = i;
+            m_flag[i] = k;
+        }
+        while (len > 0) m_stack[--top] = m_stack[--len];
+    }
+    return top;
+}
+
+bool SparseCholesky::factorize(const std::vector<double>& Ax) {
+    const int n = m_n;
+    std::vector<int>& fill = m_next;   // Next free slot in every column of L
+    for (int k = 0; k < n; ++k) fill[k] = m_Lp[k];
+    std::fill(m_flag.begin(), m_flag.end(), -1);
+
+    for (int k = 0; k < n; ++k) {
+        // Nonzero pattern of L(k, :) and scatter of A(:, k) into the dense work vector
+        int top = ereach(k);
+        m_x[k] = 0.0;
+        for (int p = m_Ap[k]; p < m_Ap[k + 1]; ++p) {
+            if (m_Ai[p] <= k) m_x[m_Ai[p]] = Ax[p];
+        }
+        double d = m_x[k];
+        m_x[k] = 0.0;
+
+        // Triangular solve for L(k, :)
+        for (; top < n; ++top) {
+            int i = m_stack[top];
+            double lki = m_x[i] / m_Lx[m_Lp[i]];
+            m_x[i] = 0.0;
+            for (int p = m_Lp[i] + 1; p < fill[i]; ++p) {
+                m_x[m_Li[p]] -= m_Lx[p] * lki;
+            }
+            d -= lki * lki;
+            int p = fill[i]++;
+            m_Li[p] = k;
+            m_Lx[p] = lki;
+        }
+        if (d <= 0.0) return false;
+
+        int p = fill[k]++;
+        m_Li[p] = k;
+        m_Lx[p] = std::sqrt(d);
+    }
+    return true;
+}
+
+void SparseCholesky::solve(std::vector<double>& x) const {
+    // L y = b
+    for (int j = 0; j < m_n; ++j) {
+        x[j] /= m_Lx[m_Lp[j]];
+        for (int p = m_Lp[j] + 1; p < m_Lp[j + 1]; ++p) {
+            x[m_Li[p]] -= m_Lx[p] * x[j];
+        }
+    }
+    // L^T x = y
+    for (int j = m_n - 1; j >= 0; --j) {
+        for (int p = m_Lp[j] + 1; p < m_Lp[j + 1]; ++p) {
+            x[j] -= m_Lx[p] * x[m_Li[p]];
+        }
+        x[j] /= m_Lx[m_Lp[j]];
+    }
+}
+
+// Geometric nested dissection on the cell grid [r0, r1) x [c0, c1). A single row of cells
+// separates the column wires and a single column of cells separates the row wires, so the
+// halves are ordered first and the separator last to keep fill-in of L low.
+static void dissect(int r0, int r1, int c0, int c1, int cols, std::vector<int>& order) {
+    int h = r1 - r0;
+    int w = c1 - c0;
+    if (h <= 0 || w <= 0) return;
+    if (h * w <= 16) {
+        for (int i = r0; i < r1; ++i) {
+            for (int j = c0; j < c1; ++j) order.push_back(i * cols + j);
+        }
+        return;
+    }
+    if (h >= w) {
+        int mid = r0 + h / 2;
+        dissect(r0, mid, c0, c1, cols, order);
+        dissect(mid + 1, r1, c0, c1, cols, order);
+        for (int j = c0; j < c1; ++j) order.push_back(mid * cols + j);
+    } else {
+        int mid = c0 + w / 2;
+        dissect(r0, r1, c0, mid, cols, order);
+        dissect(r0, r1, mid + 1, c1, cols, order);
+        for (int i = r0; i < r1; ++i) order.push_back(i * cols + mid);
+    }
+}
+
+void NewtonNodalSolver::build_structure(int rows, int cols) {
+    m_rows = rows;
+    m_cols = cols;
+    const int cells = rows * cols;
+    const int n = 2 * cells;
+
+    std::vector<int> order;
+    order.reserve(cells);
+    dissect(0, rows, 0, cols, cols, order);
+    m_elim_row.assign(cells, 0);
+    m_elim_col.assign(cells, 0);
+    for (int pos = 0; pos < cells; ++pos) {
+        m_elim_row[order[pos]] = 2 * pos;
+        m_elim_col[order[pos]] = 2 * pos + 1;
+    }
+
+    // Upper-triangular entries as (column, row, wire stamp, owner cell, slot kind)
+    enum SlotKind { Wire, RowDiag, ColDiag, Coupling };
+    std::vector<std::tuple<int, int, double, int, int>> entries;
+    entries.reserve((size_t)cells * 5);
+    auto add = [&](int a, int b, double wire, int cell, int kind) {
+        entries.emplace_back(std::max(a, b), std::min(a, b), wire, cell, kind);
+    };
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            int c = i * cols + j;
+            int er = m_elim_row[c];
+            int ec = m_elim_col[c];
+            double row_segments = (j < cols - 1) ? 2.0 : 1.0; // Left segment always exists
+            double col_segments = (i > 0) ? 2.0 : 1.0;        // Lower segment (or ground) always exists
+            add(er, er, row_segments, c, RowDiag);
+            add(ec, ec, col_segments, c, ColDiag);
+            add(er, ec, 0.0, c, Coupling);
+            if (j < cols - 1) add(er, m_elim_row[c + 1], -1.0, c, Wire);
+            if (i < rows - 1) add(ec, m_elim_col[c + cols], -1.0, c, Wire);
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    m_Ap.assign(n + 1, 0);
+    m_Ai.assign(entries.size(), 0);
+    m_wire_x.assign(entries.size(), 0.0);
+    m_slot_rr.assign(cells, 0);
+    m_slot_cc.assign(cells, 0);
+    m_slot_rc.assign(cells, 0);
+    for (size_t p = 0; p < entries.size(); ++p) {
+        auto [col, row, wire, cell, kind] = entries[p];
+        m_Ap[col + 1]++;
+        m_Ai[p] = row;
+        m_wire_x[p] = wire;
+        if (kind == RowDiag) m_slot_rr[cell] = (int)p;
+        else if (kind == ColDiag) m_slot_cc[cell] = (int)p;
+        else if (kind == Coupling) m_slot_rc[cell] = (int)p;
+    }
+    for (int k = 0; k < n; ++k) m_Ap[k + 1] += m_Ap[k];
+
+    m_Ax.assign(entries.size(), 0.0);
+    m_rhs.assign(n, 0.0);
+    m_i_cell.assign(cells, 0.0);
+    m_g_cell.assign(cells, 0.0);
+    m_chol.analyze(n, m_Ap, m_Ai);
+}
+
+template <typename T>
+NewtonNodalSolver::Result NewtonNodalSolver::solve(const DeviceBankT<T>& bank, int rows, int cols, double r_wire,
+                                                   const std::vector<T>& inputs,
+                                                   std::vector<T>& v_row, std::vector<T>& v_col) {
+    if (rows != m_rows || cols != m_cols || !m_chol.analyzed()) {
+        build_structure(rows, cols);
+    }
+
+    Result result;
+    const int cells = rows * cols;
+    const double g_wire = 1.0 / r_wire;
+    const double tol = std::max(tolerance, 8.0 * (double)std::numeric_limits<T>::epsilon());
+
+    for (int iter = 0; iter < max_iterations; ++iter) {
+        // Linearize every cell around the present node voltages
+        bank.with_kernel([&](const auto& kern) {
+            for (int c = 0; c < cells; ++c) {
+                T g = T(0);
+                m_i_cell[c] = bank.calculate_current_and_conductance(kern, (size_t)c, v_row[c] - v_col[c], g);
+                m_g_cell[c] = g;
+            }
+        });
+
+        // KCL residuals F (current leaving each node); the Newton step solves J dx = -F
+        double max_f = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                int c = i * cols + j;
+                double v = v_row[c];
+                double v_left = (j == 0) ? inputs[i] : v_row[c - 1];
+                double f_row = (v - v_left) * g_wire + m_i_cell[c];
+                if (j < cols - 1) f_row += (v - v_row[c + 1]) * g_wire;
+
+                double vc = v_col[c];
+                double v_down = (i < rows - 1) ? v_col[c + cols] : 0.0;
+                double f_col = (vc - v_down) * g_wire - m_i_cell[c];
+                if (i > 0) f_col += (vc - v_col[c - cols]) * g_wire;
+
+                m_rhs[m_elim_row[c]] = -f_row;
+                m_rhs[m_elim_col[c]] = -f_col;
+                max_f = std::max(max_f, std::max(std::abs(f_row), std::abs(f_col)));
+            }
+        }
+        double prev_residual = result.residual;
+        result.residual = max_f * r_wire;
+        if (result.residual < tol) {
+            result.converged = true;
+            break;
+        }
+        // Stagnation (e.g. the Schottky model's jump at 0 V): let the caller fall back
+        if (iter >= 4 && result.residual > 0.5 * prev_residual) break;
+
+        // Jacobian = wire Laplacian + device conductance stamps
+        for (size_t p = 0; p < m_Ax.size(); ++p) m_Ax[p] = m_wire_x[p] * g_wire;
+        for (int c = 0; c < cells; ++c) {
+            double g = m_g_cell[c];
+            m_Ax[m_slot_rr[c]] += g;
+            m_Ax[m_slot_cc[c]] += g;
+            m_Ax[m_slot_rc[c]] -= g;
+        }
+        if (!m_chol.factorize(m_Ax)) break;
+        m_chol.solve(m_rhs);
+        result.iterations = iter + 1;
+
+        // Limit the voltage update so exponential conduction models cannot overshoot wildly
+        double max_dx = 0.0;
+        for (int c = 0; c < cells; ++c) {
+            max_dx = std::max(max_dx, std::max(std::abs(m_rhs[m_elim_row[c]]), std::abs(m_rhs[m_elim_col[c]])));
+        }
+        double scale = (max_dx > 0.5) ? 0.5 / max_dx : 1.0;
+        for (int c = 0; c < cells; ++c) {
+            v_row[c] += T(scale * m_rhs[m_elim_row[c]]);
+            v_col[c] += T(scale * m_rhs[m_elim_col[c]]);
+        }
+        if (scale == 1.0 && max_dx < tol) {
+            result.converged = true;
+            break;
+        }
+    }
+    return result;
+}
+
+template NewtonNodalSolver::Result NewtonNodalSolver::solve(const DeviceBankT<double>&, int, int, double,
+                                                            const std::vector<double>&,
+                                                            std::vector<double>&, std::vector<double>&);
+template NewtonNodalSolver::Result NewtonNodalSolver::solve(const DeviceBankT<float>&, int, int, double,
+                                                            const std::vector<float>&,
+                                                            std::vector<float>&, std::vector<float>&);
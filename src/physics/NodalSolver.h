@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class DeviceBankT;
+
+// Up-looking sparse Cholesky factorization (A = L L^T) for a symmetric positive definite
+// matrix with a fixed sparsity pattern. analyze() computes the elimination tree and the
+// pattern of L once; factorize() and solve() are then repeated with new numeric values.
+// The pattern is the upper triangle of A in compressed-column form, already permuted into
+// elimination order.
+class SparseCholesky {
+public:
+    void analyze(int n, const std::vector<int>& Ap, const std::vector<int>& Ai);
+    bool factorize(const std::vector<double>& Ax);
+    void solve(std::vector<double>& x) const;
+
+    bool analyzed() const { return m_n > 0; }
+    size_t factor_nonzeros() const { return m_Li.size(); }
+
+private:
+    int ereach(int k);
+
+    int m_n = 0;
+    std::vector<int> m_Ap;
+    std::vector<int> m_Ai;
+    std::vector<int> m_parent;
+    std::vector<int> m_Lp;
+    std::vector<int> m_Li;
+    std::vector<double> m_Lx;
+
+    // Workspaces
+    std::vector<int> m_stack;
+    std::vector<int> m_flag;
+    std::vector<int> m_next;
+    std::vector<double> m_x;
+};
+
+// Newton-Raphson solver for the crossbar's 2*N*M nodal (MNA) system with wire resistance.
+// Each iteration linearizes every cell with its analytic conductance dI/dV, assembles the
+// Jacobian on a nested-dissection ordering of the grid and solves it with SparseCholesky.
+// The symbolic factorization depends only on the array shape, so it is built once and
+// reused across Newton iterations and time steps. Node voltages and device evaluations use
+// the bank's scalar type; the Jacobian is always assembled and factorized in double.
+class NewtonNodalSolver {
+public:
+    struct Result {
+        int iterations = 0;
+        double residual = 0.0;   // Largest KCL mismatch expressed in volts (|F| * r_wire)
+        bool converged = false;
+    };
+
+    // Solves in place: v_row / v_col hold the warm start on entry and the solution on exit.
+    // The tolerance is floored at a few ulps of T so a float32 array can still converge.
+    template <typename T>
+    Result solve(const DeviceBankT<T>& bank, int rows, int cols, double r_wire,
+                 const std::vector<T>& inputs,
+                 std::vector<T>& v_row, std::vector<T>& v_col);
+
+    int max_iterations = 25;
+    double tolerance = 1e-7;
+
+private:
+    void build_structure(int rows, int cols);
+
+    int m_rows = 0;
+    int m_cols = 0;
+
+    // Elimination index of every cell's row node and column node
+    std::vector<int> m_elim_row;
+    std::vector<int> m_elim_col;
+
+    // Upper-triangular Jacobian pattern plus the constant wire stamps (unit conductance)
+    std::vector<int> m_Ap;
+    std::vector<int> m_Ai;
+    std::vector<double> m_wire_x;
+    std::vector<int> m_slot_rr;
+    std::vector<int> m_slot_cc;
+    std::vector<int> m_slot_rc;
+
+    std::vector<double> m_Ax;
+    std::vector<double> m_rhs;
+    std::vector<double> m_i_cell;
+    std::vector<double> m_g_cell;
+    SparseCholesky m_chol;
+};
@@ -2,12 +2,19 @@
 #include <vector>
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <random>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include "Memristor.h"
+#include "MemristorKernels.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/TraceFile.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -22,20 +29,33 @@ struct FitDataPoint {
 class NelderMead {
 public:
     using CostFunc = std::function<double(const std::vector<double>&)>;
+    // cost(x, bound): once the value is known to exceed `bound` the evaluation may stop early
+    // and return any value above it; every simplex decision only compares against the bound.
+    using BoundedCostFunc = std::function<double(const std::vector<double>&, double)>;
+
+    static std::vector<double> Optimize(CostFunc cost, std::vector<double> init, double tol = 1e-4, int max_iter = 300,
+                                        double step = 0.15, double ftol = 0.0) {
+        return Optimize(BoundedCostFunc([&](const std::vector<double>& x, double) { return cost(x); }),
+                        std::move(init), tol, max_iter, step, ftol);
+    }
 
-    static std::vector<double> Optimize(CostFunc cost, std::vector<double> init, double tol = 1e-4, int max_iter = 300) {
+    // step: relative size of the initial simplex around init (small when refining a known optimum)
+    // ftol: also stop once the simplex's cost spread is below this fraction of the best cost
+    static std::vector<double> Optimize(BoundedCostFunc cost, std::vector<double> init, double tol = 1e-4, int max_iter = 300,
+                                        double step = 0.15, double ftol = 0.0) {
+        const double unbounded = std::numeric_limits<double>::infinity();
         int n = init.size();
         std::vector<std::vector<double>> simplex(n + 1, std::vector<double>(n));
         std::vector<double> f(n + 1);
 
         simplex[0] = init;
-        f[0] = cost(init);
+        f[0] = cost(init, unbounded);
 
         for (int i = 1; i <= n; ++i) {
             std::vector<double> point = init;
-            point[i - 1] += (std::abs(point[i - 1]) > 0.0) ? point[i - 1] * 0.15 : 0.15;
+            point[i - 1] += (std::abs(point[i - 1]) > 0.0) ? point[i - 1] * step : step;
             simplex[i] = point;
-            f[i] = cost(point);
+            f[i] = cost(point, unbounded);
         }
 
         double alpha = 1.0;
@@ -64,6 +84,7 @@ public:
                 }
             }
             if (diff < tol) break;
+            if (f[n] - f[0] <= ftol * std::abs(f[0])) break;
 
             std::vector<double> centroid(n, 0.0);
             for (int i = 0; i < n; ++i) {
@@ -77,7 +98,7 @@ public:
             for (int j = 0; j < n; ++j) {
                 xr[j] = centroid[j] + alpha * (centroid[j] - simplex[n][j]);
             }
-            double fxr = cost(xr);
+            double fxr = cost(xr, f[n]);
 
             if (f[0] <= fxr && fxr < f[n - 1]) {
                 simplex[n] = xr;
@@ -90,7 +111,7 @@ public:
                 for (int j = 0; j < n; ++j) {
                     xe[j] = centroid[j] + gamma * (xr[j] - centroid[j]);
                 }
-                double fxe = cost(xe);
+                double fxe = cost(xe, fxr);
                 if (fxe < fxr) {
                     simplex[n] = xe;
                     f[n] = fxe;
@@ -107,7 +128,7 @@ public:
                     for (int j = 0; j < n; ++j) {
                         xc[j] = centroid[j] + rho * (xr[j] - centroid[j]);
                     }
-                    double fxc = cost(xc);
+                    double fxc = cost(xc, fxr);
                     if (fxc < fxr) {
                         simplex[n] = xc;
                         f[n] = fxc;
@@ -117,7 +138,7 @@ public:
                     for (int j = 0; j < n; ++j) {
                         xc[j] = centroid[j] - rho * (centroid[j] - simplex[n][j]);
                     }
-                    double fxc = cost(xc);
+                    double fxc = cost(xc, f[n]);
                     if (fxc < f[n]) {
                         simplex[n] = xc;
                         f[n] = fxc;
@@ -130,7 +151,7 @@ public:
                 for (int j = 0; j < n; ++j) {
                     simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
                 }
-                f[i] = cost(simplex[i]);
+                f[i] = cost(simplex[i], unbounded);
             }
         }
 
@@ -138,56 +159,207 @@ public:
     }
 };
 
-class MemristorFitter {
+struct DifferentialEvolutionOptions {
+    int population = 0;          // Candidates per generation (0 = max(15, 10 x dimensions))
+    int max_generations = 150;
+    double crossover = 0.9;      // Binomial crossover rate CR
+    double f_min = 0.5;          // Mutation scale F is dithered in [f_min, f_max] per generation
+    double f_max = 1.0;
+    double tol = 1e-6;           // Stop once the population's cost spread is this fraction of the best cost
+    uint64_t seed = 1;
+    size_t workers = 0;          // Threads evaluating each generation (0 = one per core, 1 = inline)
+};
+
+// DE/rand/1/bin (Storn & Price) inside a box. A whole generation of trial vectors is built
+// first and then costed concurrently on a ThreadPool, so `cost` must be safe to call from
+// several threads at once. All random choices come from one seeded generator on the calling
+// thread, so the result does not depend on the number of workers.
+class DifferentialEvolution {
 public:
-    static std::vector<FitDataPoint> LoadCSV(const std::string& filepath, std::string& err) {
-        std::vector<FitDataPoint> dataset;
-        std::ifstream file(filepath);
-        if (!file.is_open()) {
-            err = "Could not open file: " + filepath;
-            return dataset;
-        }
+    using CostFunc = NelderMead::CostFunc;
+    using BoundedCostFunc = NelderMead::BoundedCostFunc;   // Trials are bounded by their parent's cost
 
-        std::string line;
-        if (!std::getline(file, line)) {
-            err = "Empty file: " + filepath;
-            return dataset;
-        }
+    static std::vector<double> Optimize(CostFunc cost, const std::vector<double>& init, const std::vector<double>& lower,
+                                        const std::vector<double>& upper, const DifferentialEvolutionOptions& opts = {}) {
+        return Optimize(BoundedCostFunc([&](const std::vector<double>& x, double) { return cost(x); }),
+                        init, lower, upper, opts);
+    }
+
+    static std::vector<double> Optimize(BoundedCostFunc cost, const std::vector<double>& init, const std::vector<double>& lower,
+                                        const std::vector<double>& upper, const DifferentialEvolutionOptions& opts = {}) {
+        const double unbounded = std::numeric_limits<double>::infinity();
+        int n = init.size();
+        int np = opts.population > 0 ? std::max(4, opts.population) : std::max(15, 10 * n);
+        std::mt19937_64 rng(opts.seed);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::uniform_int_distribution<int> pick(0, np - 1);
+        std::uniform_int_distribution<int> pick_dim(0, n - 1);
+
+        std::unique_ptr<ThreadPool> pool;
+        if (opts.workers != 1) pool = std::make_unique<ThreadPool>(opts.workers);
+        auto evaluate = [&](const std::vector<std::vector<double>>& xs, std::vector<double>& fs, const std::vector<double>* bounds) {
+            auto one = [&](size_t k) { fs[k] = cost(xs[k], bounds ? (*bounds)[k] : unbounded); };
+            if (pool) {
+                pool->parallel_for(xs.size(), [&](size_t k, size_t) { one(k); });
+            } else {
+                for (size_t k = 0; k < xs.size(); ++k) one(k);
+            }
+        };
 
-        double last_t = 0.0;
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
-            std::string item;
-            std::vector<double> vals;
-            while (std::getline(ss, item, ',')) {
-                try {
-                    vals.push_back(std::stod(item));
-                } catch (...) {
-                    // skip non-numeric items
+        // Initial population: the starting point plus uniform samples of the box
+        std::vector<std::vector<double>> pop(np, std::vector<double>(n));
+        std::vector<double> f(np);
+        for (int j = 0; j < n; ++j) pop[0][j] = std::min(std::max(init[j], lower[j]), upper[j]);
+        for (int i = 1; i < np; ++i) {
+            for (int j = 0; j < n; ++j) pop[i][j] = lower[j] + unit(rng) * (upper[j] - lower[j]);
+        }
+        evaluate(pop, f, nullptr);
+
+        std::vector<std::vector<double>> trial(np, std::vector<double>(n));
+        std::vector<double> ft(np);
+        for (int gen = 0; gen < opts.max_generations; ++gen) {
+            auto [lo_it, hi_it] = std::minmax_element(f.begin(), f.end());
+            if (*hi_it - *lo_it <= opts.tol * std::abs(*lo_it)) break;
+
+            double F = opts.f_min + unit(rng) * (opts.f_max - opts.f_min);
+            for (int i = 0; i < np; ++i) {
+                int a, b, c;
+                do { a = pick(rng); } while (a == i);
+                do { b = pick(rng); } while (b == i || b == a);
+                do { c = pick(rng); } while (c == i || c == a || c == b);
+                int forced = pick_dim(rng);
+                for (int j = 0; j < n; ++j) {
+                    double x = pop[i][j];
+                    if (j == forced || unit(rng) < opts.crossover) {
+                        x = pop[a][j] + F * (pop[b][j] - pop[c][j]);
+                        // Out-of-box components land halfway between the base vector and the wall
+                        if (x < lower[j]) x = 0.5 * (pop[a][j] + lower[j]);
+                        if (x > upper[j]) x = 0.5 * (pop[a][j] + upper[j]);
+                    }
+                    trial[i][j] = x;
                 }
             }
+            evaluate(trial, ft, &f);
 
-            if (vals.size() >= 3) {
-                FitDataPoint pt;
-                pt.t = vals[0];
-                pt.v = vals[1];
-                pt.i = vals[2];
-                dataset.push_back(pt);
-                last_t = vals[0];
-            } else if (vals.size() == 2) {
-                FitDataPoint pt;
-                pt.t = last_t;
-                pt.v = vals[0];
-                pt.i = vals[1];
-                dataset.push_back(pt);
-                last_t += 0.01;
+            for (int i = 0; i < np; ++i) {
+                if (ft[i] <= f[i]) {
+                    pop[i] = trial[i];
+                    f[i] = ft[i];
+                }
             }
         }
-        
-        if (dataset.empty()) {
-            err = "No data parsed. Requires Time,Voltage,Current or Voltage,Current.";
+
+        int best = std::min_element(f.begin(), f.end()) - f.begin();
+        return pop[best];
+    }
+};
+
+// Parameter groups MemristorFitter can fit, combined as a bit mask
+enum FitParameter : unsigned {
+    FitResistance = 1u << 0,   // R_on, R_off
+    FitRates = 1u << 1,        // k_on, k_off
+    FitAlpha = 1u << 2,        // alpha_on, alpha_off
+    FitThresholds = 1u << 3,   // v_on, v_off
+    FitConduction = 1u << 4,   // gamma_sinh / beta_pf / beta_sc of the active conduction model
+};
+
+enum class FitMethod { NelderMead, DifferentialEvolution, LevenbergMarquardt };
+
+struct FitOptions {
+    FitMethod method = FitMethod::NelderMead;
+    unsigned parameters = FitResistance | FitRates;
+    DifferentialEvolutionOptions de;
+    bool polish = true;          // Finish a DE run with a Nelder-Mead refinement of the best point
+
+    // Multi-resolution schedule: up to coarse_levels stages on the dataset decimated by 4^level
+    // (coarsest first, loose tolerance) seed the full-data refinement. Levels that would keep
+    // fewer than coarse_min_points samples are skipped, so short traces fit in one stage.
+    int coarse_levels = 2;
+    size_t coarse_min_points = 2000;
+    // Stop replaying the dataset once a candidate's partial error exceeds the value it has to beat
+    bool early_abort = true;
+
+    // Keep D2D/C2C variability, RTN and read noise in the fitted model. Off by default, so the
+    // cost is a deterministic function of the parameters; LevenbergMarquardt is always noise-free.
+    bool stochastic = false;
+    int lm_iterations = 50;      // Levenberg-Marquardt: at most this many Jacobian passes
+};
+
+class MemristorFitter {
+public:
+    // One fitted field and its search box, in optimizer coordinates (log10 |value| when log_scale)
+    struct Variable {
+        const char* name;
+        double MemristorParams::* field;
+        bool log_scale;
+        double sign;
+        double lower;
+        double upper;
+    };
+
+    static std::vector<Variable> Variables(unsigned mask, ConductionModel model) {
+        std::vector<Variable> vars;
+        if (mask & FitResistance) {
+            vars.push_back({"R_on", &MemristorParams::R_on, true, 1.0, 0.0, 7.0});
+            vars.push_back({"R_off", &MemristorParams::R_off, true, 1.0, 0.0, 7.0});
+        }
+        if (mask & FitRates) {
+            vars.push_back({"k_on", &MemristorParams::k_on, true, 1.0, -1.0, 6.0});
+            vars.push_back({"k_off", &MemristorParams::k_off, true, -1.0, -1.0, 6.0});
+        }
+        if (mask & FitAlpha) {
+            vars.push_back({"alpha_on", &MemristorParams::alpha_on, false, 1.0, 1.0, 10.0});
+            vars.push_back({"alpha_off", &MemristorParams::alpha_off, false, 1.0, 1.0, 10.0});
+        }
+        if (mask & FitThresholds) {
+            vars.push_back({"v_on", &MemristorParams::v_on, false, 1.0, -3.0, -0.05});
+            vars.push_back({"v_off", &MemristorParams::v_off, false, 1.0, 0.05, 3.0});
+        }
+        if (mask & FitConduction) {
+            if (model == ConductionModel::Sinh) vars.push_back({"gamma_sinh", &MemristorParams::gamma_sinh, false, 1.0, 0.1, 10.0});
+            if (model == ConductionModel::PooleFrenkel) vars.push_back({"beta_pf", &MemristorParams::beta_pf, false, 1.0, 0.1, 10.0});
+            if (model == ConductionModel::Schottky) vars.push_back({"beta_sc", &MemristorParams::beta_sc, false, 1.0, 0.1, 10.0});
+        }
+        return vars;
+    }
+
+    static std::vector<double> Encode(const std::vector<Variable>& vars, const MemristorParams& p) {
+        std::vector<double> x;
+        for (const auto& v : vars) {
+            double value = p.*v.field;
+            x.push_back(v.log_scale ? std::log10(std::max(std::abs(value), 1e-300)) : value);
+        }
+        return x;
+    }
+
+    static MemristorParams Decode(const std::vector<Variable>& vars, const std::vector<double>& x, const MemristorParams& base) {
+        MemristorParams p = base;
+        for (size_t k = 0; k < vars.size(); ++k) {
+            p.*vars[k].field = vars[k].log_scale ? vars[k].sign * std::pow(10.0, x[k]) : x[k];
         }
-        return dataset;
+        return p;
+    }
+
+    // Measured trace in the columnar form Fit reads, straight from the loader (no second copy
+    // of multi-million-row traces). Accepts Time,Voltage,Current or Voltage,Current CSVs and
+    // TraceFile binary caches; see TraceFile for the parser and the cache options.
+    static TraceColumns LoadCSV(const std::string& filepath, std::string& err,
+                                const TraceLoadOptions& options = TraceLoadOptions()) {
+        TraceColumns trace;
+        if (!TraceFile::Load(filepath, trace, err, options)) trace = TraceColumns();
+        return trace;
+    }
+
+    // Samples as TraceColumns, for callers that build small datasets point by point
+    static TraceColumns Columns(const std::vector<FitDataPoint>& dataset) {
+        TraceColumns trace;
+        trace.resize(dataset.size());
+        for (size_t k = 0; k < dataset.size(); ++k) {
+            trace.t[k] = dataset[k].t;
+            trace.v[k] = dataset[k].v;
+            trace.i[k] = dataset[k].i;
+        }
+        return trace;
     }
 
     static void GenerateSyntheticCSV(const std::string& filepath, const MemristorParams& true_params) {
@@ -215,52 +387,290 @@ public:
         }
     }
 
-    static MemristorParams Fit(const std::vector<FitDataPoint>& dataset, const MemristorParams& base_params, double& final_mse) {
-        if (dataset.empty()) return base_params;
-
-        std::vector<double> init(4);
-        init[0] = std::log10(base_params.R_on);
-        init[1] = std::log10(base_params.R_off);
-        init[2] = std::log10(base_params.k_on);
-        init[3] = std::log10(std::abs(base_params.k_off));
-
-        NelderMead::CostFunc cost = [&](const std::vector<double>& x) -> double {
-            MemristorParams params = base_params;
-            params.R_on = std::pow(10.0, x[0]);
-            params.R_off = std::pow(10.0, x[1]);
-            params.k_on = std::pow(10.0, x[2]);
-            params.k_off = -std::pow(10.0, x[3]);
-
-            if (params.R_on < 1.0 || params.R_on > params.R_off) return 1e12;
-            if (params.R_off > 1e7) return 1e12;
-            if (params.k_on < 0.1 || params.k_on > 1e6) return 1e12;
-            if (std::abs(params.k_off) < 0.1 || std::abs(params.k_off) > 1e6) return 1e12;
-
-            PhysicsEngine model(params);
-            double total_se = 0.0;
-            
-            for (size_t i = 1; i < dataset.size(); ++i) {
-                double dt = dataset[i].t - dataset[i - 1].t;
+    // The same parameters with every stochastic term switched off
+    static MemristorParams Deterministic(MemristorParams p) {
+        p.enable_variability = false;
+        p.enable_rtn = false;
+        p.enable_read_noise = false;
+        return p;
+    }
+
+    // Noise-free replay of the dataset (PhysicsEngine::update with p.integrator, the adaptive
+    // step carried between samples) with the fittable fields held as T. visit(i, current) receives the model current of every
+    // sample i >= 1 and returns false to stop the replay. The selector split is solved on values,
+    // so with a selector the parameter derivatives treat V_mem as fixed within each sample.
+    template <typename T, typename Visit>
+    static void Replay(const TraceColumns& trace, const MemristorParamsT<T>& p,
+                       int alpha_on_int, int alpha_off_int, Visit&& visit) {
+        using std::fabs;
+        const MemristorParams& pv = p.values();
+        const double tau_thermal = 0.01;
+        // One kernel dispatch per replay; the series split uses the same policy on values
+        with_device_kernel(p, DeviceConstants<T>(p), [&](const auto& kern) {
+            using Policy = typename std::decay_t<decltype(kern)>::policy;
+            const DeviceKernel<Policy, double> kern_v{DeviceConstants<double>(pv)};
+            T w = pv.w_init;
+            T dT = 0.0;
+            double share = 0.5;   // Warm start of the series split, carried from sample to sample
+            double h = 0.0;       // Adaptive integrator step, carried likewise
+            int substeps = 0;
+            bool failed = false;   // Keeps the last finite state, as PhysicsEngine does
+            for (size_t i = 1; i < trace.size(); ++i) {
+                double dt = trace.t[i] - trace.t[i - 1];
                 if (dt <= 0.0) dt = 0.01;
-                
-                model.update(dt, dataset[i].v);
-                
-                double diff = model.i() - dataset[i].i;
-                total_se += diff * diff;
+                double v = trace.v[i];
+
+                if (!is_subthreshold(pv, v, value_of(dT))) {
+                    T v_mem = kern_v.series_v_mem(value_of(w), 0, v, share);
+                    if (pv.integrator == IntegratorMode::RK4) {
+                        w = rk4_step(p, alpha_on_int, alpha_off_int, p.k_on, p.k_off, v_mem, w, dT, dt);
+                    } else {
+                        w = integrate_embedded_rk(pv.integrator, [&](T ws) {
+                            return memristor_dw_dt(p, alpha_on_int, alpha_off_int, p.k_on, p.k_off, v_mem, ws, dT);
+                        }, w, dt, pv.integrator_rtol, pv.integrator_atol, h, substeps, failed);
+                    }
+                }
+                w = clamp01(w);
+
+                T current = kern.memristor_current(w, 0, T(kern_v.series_v_mem(value_of(w), 0, v, share)));
+                if (!visit(i, current)) return;
+                dT += (dt / (dt + tau_thermal)) * (fabs(current * v) * pv.theta_thermal - dT);
             }
-            
-            return total_se / dataset.size();
+        });
+    }
+
+    // Levenberg-Marquardt on the current residuals, in optimizer coordinates. Each iteration
+    // takes one dual-number replay for the residuals and their exact Jacobian J, then solves the
+    // damped normal equations (J^T J + lambda diag(J^T J)) dx = -J^T r. Trial points are clipped
+    // to the box and costed with plain replays that stop once they are worse than the current one.
+    template <int N>
+    static std::vector<double> LevenbergMarquardt(const TraceColumns& trace, const std::vector<Variable>& vars,
+                                                  const MemristorParams& base, std::vector<double> x,
+                                                  const std::vector<double>& lower, const std::vector<double>& upper,
+                                                  int max_iter) {
+        const double unbounded = std::numeric_limits<double>::infinity();
+        // A fitted alpha needs the std::pow branch, whose slope in alpha is not zero
+        auto exponent = [&](double MemristorParams::* field, double alpha) {
+            for (const auto& v : vars) {
+                if (v.field == field) return -1;
+            }
+            return integral_exponent(alpha);
+        };
+        auto sse = [&](const std::vector<double>& xv, double bound) {
+            MemristorParams pv = Decode(vars, xv, base);
+            if (pv.R_on > pv.R_off) return unbounded;
+            MemristorParamsT<double> p(pv);
+            double total = 0.0;
+            Replay(trace, p, exponent(&MemristorParams::alpha_on, pv.alpha_on),
+                   exponent(&MemristorParams::alpha_off, pv.alpha_off), [&](size_t i, double current) {
+                       double r = current - trace.i[i];
+                       total += r * r;
+                       return total <= bound;
+                   });
+            return total;
+        };
+
+        double lambda = 1e-3;
+        for (int iter = 0; iter < max_iter; ++iter) {
+            // Residuals and normal equations at x
+            MemristorParams pv = Decode(vars, x, base);
+            MemristorParamsT<Dual<N>> p(pv);
+            for (int k = 0; k < N; ++k) {
+                Dual<N>* field = p.field(vars[k].field);
+                if (!field) continue;
+                double value = pv.*vars[k].field;
+                *field = Dual<N>::Seed(value, k, vars[k].log_scale ? value * std::log(10.0) : 1.0);
+            }
+            double jtj[N][N] = {};
+            double jtr[N] = {};
+            double f = 0.0;
+            Replay(trace, p, exponent(&MemristorParams::alpha_on, pv.alpha_on),
+                   exponent(&MemristorParams::alpha_off, pv.alpha_off), [&](size_t i, const Dual<N>& current) {
+                       double r = current.v - trace.i[i];
+                       f += r * r;
+                       for (int a = 0; a < N; ++a) {
+                           jtr[a] += current.d[a] * r;
+                           for (int b = 0; b <= a; ++b) jtj[a][b] += current.d[a] * current.d[b];
+                       }
+                       return true;
+                   });
+
+            // Raise the damping until a step lowers the cost
+            bool accepted = false;
+            double f_new = f;
+            double max_step = 0.0;
+            while (!accepted && lambda < 1e12) {
+                double m[N][N];
+                double dx[N];
+                for (int a = 0; a < N; ++a) {
+                    for (int b = 0; b <= a; ++b) m[a][b] = jtj[a][b];
+                    m[a][a] += lambda * std::max(jtj[a][a], 1e-30);
+                    dx[a] = -jtr[a];
+                }
+                if (!SolveCholesky<N>(m, dx)) {
+                    lambda *= 10.0;
+                    continue;
+                }
+                std::vector<double> trial = x;
+                max_step = 0.0;
+                for (int k = 0; k < N; ++k) {
+                    trial[k] = std::min(std::max(x[k] + dx[k], lower[k]), upper[k]);
+                    max_step = std::max(max_step, std::abs(trial[k] - x[k]));
+                }
+                f_new = sse(trial, f);
+                if (f_new < f) {
+                    x = trial;
+                    lambda = std::max(lambda * 0.1, 1e-12);
+                    accepted = true;
+                } else {
+                    lambda *= 10.0;
+                }
+            }
+            if (!accepted || f - f_new <= 1e-10 * f || max_step < 1e-9) break;
+        }
+        return x;
+    }
+
+    static MemristorParams Fit(const std::vector<FitDataPoint>& dataset, const MemristorParams& base_params, double& final_mse) {
+        return Fit(Columns(dataset), base_params, final_mse, FitOptions{});
+    }
+
+    static MemristorParams Fit(const std::vector<FitDataPoint>& dataset, const MemristorParams& base_params, double& final_mse,
+                               const FitOptions& opts) {
+        return Fit(Columns(dataset), base_params, final_mse, opts);
+    }
+
+    static MemristorParams Fit(const TraceColumns& trace, const MemristorParams& base_params, double& final_mse) {
+        return Fit(trace, base_params, final_mse, FitOptions{});
+    }
+
+    static MemristorParams Fit(const TraceColumns& trace, const MemristorParams& base_params, double& final_mse,
+                               const FitOptions& opts) {
+        if (trace.empty()) return base_params;
+
+        std::vector<Variable> vars = Variables(opts.parameters, base_params.conduction_model);
+        if (vars.empty()) return base_params;
+        std::vector<double> init = Encode(vars, base_params);
+        std::vector<double> lower, upper;
+        for (const auto& v : vars) {
+            lower.push_back(v.lower);
+            upper.push_back(v.upper);
+        }
+
+        // Parameters as seen by the cost; the fitted result keeps the noise settings of base_params
+        const MemristorParams model_base = opts.stochastic ? base_params : Deterministic(base_params);
+
+        // MSE of the model replayed over every stride-th sample. Thread-safe: every call builds
+        // its own engine, seeded identically so all candidates see the same noise realization.
+        auto make_cost = [&](size_t stride) {
+            return NelderMead::BoundedCostFunc([&, stride](const std::vector<double>& x, double bound) -> double {
+                for (size_t k = 0; k < x.size(); ++k) {
+                    if (!(x[k] >= lower[k] && x[k] <= upper[k])) return 1e12;
+                }
+                MemristorParams params = Decode(vars, x, model_base);
+                if (params.R_on > params.R_off) return 1e12;
+
+                PhysicsEngine model(params);
+                model.seed(opts.de.seed);
+                model.reset();
+                double samples = (double)((trace.size() + stride - 1) / stride);
+                double sse_limit = opts.early_abort ? bound * samples : std::numeric_limits<double>::infinity();
+                double total_se = 0.0;
+
+                for (size_t i = stride; i < trace.size(); i += stride) {
+                    double dt = trace.t[i] - trace.t[i - stride];
+                    if (dt <= 0.0) dt = 0.01 * stride;
+
+                    model.update(dt, trace.v[i]);
+
+                    double diff = model.i() - trace.i[i];
+                    total_se += diff * diff;
+                    if (total_se > sse_limit) {
+                        // Already worse than the point it competes with: the exact value is not needed
+                        return std::max(total_se / samples, std::nextafter(bound, std::numeric_limits<double>::infinity()));
+                    }
+                }
+
+                return total_se / samples;
+            });
         };
 
-        std::vector<double> best_x = NelderMead::Optimize(cost, init, 1e-5, 200);
+        if (opts.method == FitMethod::LevenbergMarquardt) {
+            std::vector<double> best_x = FitLevenbergMarquardt(trace, vars, Deterministic(base_params), init, lower,
+                                                               upper, opts.lm_iterations);
+            final_mse = make_cost(1)(best_x, std::numeric_limits<double>::infinity());
+            return Decode(vars, best_x, base_params);
+        }
 
-        MemristorParams fitted_params = base_params;
-        fitted_params.R_on = std::pow(10.0, best_x[0]);
-        fitted_params.R_off = std::pow(10.0, best_x[1]);
-        fitted_params.k_on = std::pow(10.0, best_x[2]);
-        fitted_params.k_off = -std::pow(10.0, best_x[3]);
+        std::vector<size_t> strides;
+        for (int level = std::max(0, opts.coarse_levels); level > 0; --level) {
+            size_t stride = (size_t)1 << (2 * level);
+            if (trace.size() / stride >= opts.coarse_min_points) strides.push_back(stride);
+        }
+        strides.push_back(1);
+
+        // The first stage searches globally. Later ones refine from a tight simplex around the
+        // previous optimum instead of re-exploring the whole basin. Coarse stages stop 10x looser
+        // per level, or once their costs agree to 1e-4. After a coarse search, the full-data stage
+        // stops when its costs agree to 1e-8, well below any measurement noise.
+        std::vector<double> best_x = init;
+        for (size_t level = 0; level < strides.size(); ++level) {
+            bool full = strides[level] == 1;
+            auto cost = make_cost(strides[level]);
+            if (level == 0 && opts.method == FitMethod::DifferentialEvolution) {
+                best_x = DifferentialEvolution::Optimize(cost, best_x, lower, upper, opts.de);
+                if (full && !opts.polish) continue;
+            }
+            double tol = 1e-5 * std::pow(10.0, (double)(strides.size() - 1 - level));
+            double ftol = full ? (level > 0 ? 1e-8 : 0.0) : 1e-4;
+            best_x = NelderMead::Optimize(cost, best_x, tol, 200, level > 0 ? 0.003 : 0.15, ftol);
+        }
+
+        final_mse = make_cost(1)(best_x, std::numeric_limits<double>::infinity());
+        return Decode(vars, best_x, base_params);
+    }
 
-        final_mse = cost(best_x);
-        return fitted_params;
+private:
+    // Solves m x = b in place for symmetric positive definite m (lower triangle used)
+    template <int N>
+    static bool SolveCholesky(double (&m)[N][N], double (&b)[N]) {
+        for (int j = 0; j < N; ++j) {
+            double d = m[j][j];
+            for (int k = 0; k < j; ++k) d -= m[j][k] * m[j][k];
+            if (!(d > 0.0)) return false;
+            m[j][j] = std::sqrt(d);
+            for (int i = j + 1; i < N; ++i) {
+                double s = m[i][j];
+                for (int k = 0; k < j; ++k) s -= m[i][k] * m[j][k];
+                m[i][j] = s / m[j][j];
+            }
+        }
+        for (int i = 0; i < N; ++i) {
+            for (int k = 0; k < i; ++k) b[i] -= m[i][k] * b[k];
+            b[i] /= m[i][i];
+        }
+        for (int i = N - 1; i >= 0; --i) {
+            for (int k = i + 1; k < N; ++k) b[i] -= m[k][i] * b[k];
+            b[i] /= m[i][i];
+        }
+        return true;
+    }
+
+    // Dispatches on the number of fitted variables (at most 9, see Variables)
+    static std::vector<double> FitLevenbergMarquardt(const TraceColumns& trace, const std::vector<Variable>& vars,
+                                                     const MemristorParams& base, const std::vector<double>& init,
+                                                     const std::vector<double>& lower, const std::vector<double>& upper,
+                                                     int max_iter) {
+        switch (vars.size()) {
+        case 1: return LevenbergMarquardt<1>(trace, vars, base, init, lower, upper, max_iter);
+        case 2: return LevenbergMarquardt<2>(trace, vars, base, init, lower, upper, max_iter);
+        case 3: return LevenbergMarquardt<3>(trace, vars, base, init, lower, upper, max_iter);
+        case 4: return LevenbergMarquardt<4>(trace, vars, base, init, lower, upper, max_iter);
+        case 5: return LevenbergMarquardt<5>(trace, vars, base, init, lower, upper, max_iter);
+        case 6: return LevenbergMarquardt<6>(trace, vars, base, init, lower, upper, max_iter);
+        case 7: return LevenbergMarquardt<7>(trace, vars, base, init, lower, upper, max_iter);
+        case 8: return LevenbergMarquardt<8>(trace, vars, base, init, lower, upper, max_iter);
+        default: return LevenbergMarquardt<9>(trace, vars, base, init, lower, upper, max_iter);
+        }
     }
 };
@@ -0,0 +1,215 @@
+#include "SimulationWorker.h"
+#include "../utils/TraceRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using Clock = std::chrono::steady_clock;
+
+// Wall time one batch may hold the state mutex
+static const std::chrono::microseconds kBatchTime(1000);
+// Steps checked between clock reads within a batch
+static const uint64_t kClockInterval = 16;
+// Wall seconds the schedule may fall behind before it restarts from the current step
+static const double kMaxBacklog = 0.05;
+// Wall seconds over which the achieved rate is measured
+static const double kRateWindow = 0.5;
+// Display-window samples kept per wall second; the recording keeps every step
+static const double kDisplayRate = 120.0;
+// Snapshot refresh while paused, so edits made from the GUI still show
+static const std::chrono::milliseconds kPausedRefresh(20);
+
+static double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+SimulationWorker::SimulationWorker(PhysicsEngine& physics, CrossbarArray& crossbar, WaveformGenerator& waveform,
+                                   TraceRecorder* recorder)
+    : m_physics(physics), m_crossbar(crossbar), m_waveform(waveform), m_recorder(recorder) {}
+
+SimulationWorker::~SimulationWorker() { stop(); }
+
+void SimulationWorker::start() {
+    if (m_thread.joinable()) return;
+    m_quit.store(false);
+    m_thread = std::thread(&SimulationWorker::run, this);
+}
+
+void SimulationWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_quit.store(true);
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::unique_lock<std::mutex> SimulationWorker::lock_state() {
+    m_lock_waiters.fetch_add(1);
+    std::unique_lock<std::mutex> lock(m_state_mutex);
+    m_lock_waiters.fetch_sub(1);
+    return lock;
+}
+
+void SimulationWorker::set_fixed_step(double dt) {
+    if (!(dt > 0.0)) return;
+    m_fixed_step.store(dt);
+    m_schedule_generation.fetch_add(1);
+    m_wake.notify_all();
+}
+
+void SimulationWorker::set_time_scale(double scale) {
+    m_time_scale.store(scale > 0.0 ? scale : 0.0);
+    m_schedule_generation.fetch_add(1);
+    m_wake.notify_all();
+}
+
+void SimulationWorker::set_paused(bool paused) {
+    m_paused.store(paused);
+    m_schedule_generation.fetch_add(1);
+    m_wake.notify_all();
+}
+
+void SimulationWorker::set_crossbar_mode(bool crossbar) {
+    if (m_crossbar_mode.exchange(crossbar) == crossbar) return;
+    m_schedule_generation.fetch_add(1);
+    m_wake.notify_all();
+}
+
+void SimulationWorker::snapshot(SimulationSnapshot& out) const {
+    std::lock_guard<std::mutex> lock(m_snapshot_mutex);
+    out = m_snapshots[m_front];
+}
+
+void SimulationWorker::step_once(double dt, bool crossbar) {
+    m_time += dt;
+    ++m_steps;
+    if (crossbar) {
+        m_crossbar.update(dt);
+        return;
+    }
+    m_voltage = m_waveform.get_voltage(m_time);
+    m_physics.update(dt, m_voltage);
+    if (m_recorder) {
+        m_recorder->push({m_time, m_voltage, m_physics.i(), m_physics.r(), m_physics.w(), m_physics.dT()});
+    }
+}
+
+// Called with the state mutex held
+void SimulationWorker::publish(bool crossbar, double steps_per_second, double real_time_factor, bool lagging) {
+    SimulationSnapshot& s = m_snapshots[1 - m_front];
+    s.steps = m_steps;
+    s.time = m_time;
+    s.crossbar_mode = crossbar;
+    s.voltage = m_voltage;
+    s.w = m_physics.w();
+    s.r = m_physics.r();
+    s.i = m_physics.i();
+    s.power = m_physics.power();
+    s.dT = m_physics.dT();
+    s.substeps = m_physics.last_substeps();
+    s.rows = m_crossbar.rows();
+    s.cols = m_crossbar.cols();
+    s.cell_w.resize((size_t)s.rows * s.cols);
+    s.cell_power.resize((size_t)s.rows * s.cols);
+    for (int r = 0; r < s.rows; ++r) {
+        for (int c = 0; c < s.cols; ++c) {
+            s.cell_w[(size_t)r * s.cols + c] = m_crossbar.w(r, c);
+            s.cell_power[(size_t)r * s.cols + c] = m_crossbar.power(r, c);
+        }
+    }
+    s.steps_per_second = steps_per_second;
+    s.real_time_factor = real_time_factor;
+    s.lagging = lagging;
+
+    std::lock_guard<std::mutex> lock(m_snapshot_mutex);
+    m_front = 1 - m_front;
+}
+
+void SimulationWorker::run() {
+    uint64_t generation = m_schedule_generation.load() - 1;
+    Clock::time_point anchor;
+    uint64_t anchor_steps = 0;
+
+    Clock::time_point rate_start = Clock::now();
+    uint64_t rate_steps = m_steps;
+    double rate_time = m_time;
+    double steps_per_second = 0.0;
+    double real_time_factor = 0.0;
+    bool lagging = false;
+    bool lagged_in_window = false;
+
+    while (!m_quit.load()) {
+        bool crossbar = m_crossbar_mode.load();
+        if (m_paused.load()) {
+            {
+                std::unique_lock<std::mutex> lock(m_state_mutex);
+                publish(crossbar, 0.0, 0.0, false);
+            }
+            std::unique_lock<std::mutex> wake(m_wake_mutex);
+            m_wake.wait_for(wake, kPausedRefresh, [this] { return m_quit.load() || !m_paused.load(); });
+            rate_start = Clock::now();
+            rate_steps = m_steps;
+            rate_time = m_time;
+            continue;
+        }
+
+        double dt = m_fixed_step.load();
+        double scale = m_time_scale.load();
+        Clock::time_point now = Clock::now();
+        uint64_t gen = m_schedule_generation.load();
+        if (gen != generation) {
+            generation = gen;
+            anchor = now;
+            anchor_steps = m_steps;
+        }
+
+        // Steps due by the wall clock, at most kMaxBacklog behind
+        uint64_t budget = UINT64_MAX;
+        if (scale > 0.0) {
+            double steps_per_wall_second = scale / dt;
+            double due = seconds(now - anchor) * steps_per_wall_second - (double)(m_steps - anchor_steps);
+            if (due < 1.0) {
+                auto wait = std::chrono::duration<double>((1.0 - due) / steps_per_wall_second);
+                std::unique_lock<std::mutex> wake(m_wake_mutex);
+                m_wake.wait_for(wake, std::min<std::chrono::duration<double>>(wait, kBatchTime),
+                                [this, gen] { return m_quit.load() || m_schedule_generation.load() != gen; });
+                continue;
+            }
+            double max_due = std::max(1.0, kMaxBacklog * steps_per_wall_second);
+            if (due > max_due) {
+                lagged_in_window = true;
+                anchor = now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(kMaxBacklog));
+                anchor_steps = m_steps;
+                due = max_due;
+            }
+            budget = (uint64_t)due;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_state_mutex);
+            Clock::time_point batch_end = now + kBatchTime;
+            for (uint64_t k = 1; k <= budget; ++k) {
+                step_once(dt, crossbar);
+                if (m_lock_waiters.load(std::memory_order_relaxed) > 0) break;
+                if (k % kClockInterval == 0 && Clock::now() >= batch_end) break;
+            }
+
+            double window = seconds(Clock::now() - rate_start);
+            if (window >= kRateWindow) {
+                steps_per_second = (double)(m_steps - rate_steps) / window;
+                real_time_factor = (m_time - rate_time) / window;
+                lagging = lagged_in_window;
+                lagged_in_window = false;
+                rate_start = Clock::now();
+                rate_steps = m_steps;
+                rate_time = m_time;
+                if (m_recorder) {
+                    m_recorder->set_recent_stride((size_t)std::max(1.0, std::round(steps_per_second / kDisplayRate)));
+                }
+            }
+            publish(crossbar, steps_per_second, real_time_factor, lagging);
+        }
+
+        // Let a waiting lock_state() in before the next batch
+        while (m_lock_waiters.load() > 0 && !m_quit.load()) std::this_thread::yield();
+    }
+}
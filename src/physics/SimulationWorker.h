@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Memristor.h"
+#include "Crossbar.h"
+#include "../utils/Waveform.h"
+
+class TraceRecorder;
+
+// State published by SimulationWorker for the renderer and the GUI readouts
+struct SimulationSnapshot {
+    uint64_t steps = 0;        // Steps taken since start()
+    double time = 0.0;         // Simulation time (s)
+    bool crossbar_mode = false;
+
+    // Single device
+    double voltage = 0.0;
+    double w = 0.0;
+    double r = 0.0;
+    double i = 0.0;
+    double power = 0.0;
+    double dT = 0.0;
+    int substeps = 0;
+
+    // Crossbar cells, row-major
+    int rows = 0;
+    int cols = 0;
+    std::vector<double> cell_w;
+    std::vector<double> cell_power;
+
+    // Rate achieved over the last half second of wall time
+    double steps_per_second = 0.0;
+    double real_time_factor = 0.0;   // Simulated seconds per wall second
+    bool lagging = false;            // The requested rate could not be kept up
+};
+
+// Advances the single-device engine (driven by the waveform) or the crossbar at a fixed
+// step on its own thread, decoupled from the frame rate. Steps are scheduled against the wall
+// clock: time_scale simulated seconds per wall second, i.e. time_scale / fixed_step steps per
+// second, or as fast as possible with time_scale 0. When the requested rate cannot be kept the
+// schedule restarts from the current step rather than bursting to catch up, and the snapshot
+// reports lagging.
+//
+// Steps run in batches of about a millisecond while holding the state mutex. Anything that
+// reads or edits the engine, the array or the waveform from another thread takes lock_state()
+// first; a pending lock_state() ends the running batch early, so the GUI waits at most one
+// step. After every batch the worker publishes a SimulationSnapshot into the back half of a
+// double buffer and swaps it in, so the renderer and readouts copy a consistent state without
+// touching the live objects. In device mode every step is pushed to the TraceRecorder.
+class SimulationWorker {
+public:
+    SimulationWorker(PhysicsEngine& physics, CrossbarArray& crossbar, WaveformGenerator& waveform,
+                     TraceRecorder* recorder = nullptr);
+    ~SimulationWorker();
+
+    SimulationWorker(const SimulationWorker&) = delete;
+    SimulationWorker& operator=(const SimulationWorker&) = delete;
+
+    void start();
+    void stop();
+
+    std::unique_lock<std::mutex> lock_state();
+
+    void set_fixed_step(double dt);
+    double fixed_step() const { return m_fixed_step.load(); }
+    void set_time_scale(double scale);
+    double time_scale() const { return m_time_scale.load(); }
+    void set_paused(bool paused);
+    bool paused() const { return m_paused.load(); }
+    void set_crossbar_mode(bool crossbar);
+
+    // Copies the latest published state
+    void snapshot(SimulationSnapshot& out) const;
+
+private:
+    void run();
+    void step_once(double dt, bool crossbar);
+    void publish(bool crossbar, double steps_per_second, double real_time_factor, bool lagging);
+
+    PhysicsEngine& m_physics;
+    CrossbarArray& m_crossbar;
+    WaveformGenerator& m_waveform;
+    TraceRecorder* m_recorder;
+
+    std::mutex m_state_mutex;
+    std::atomic<int> m_lock_waiters{0};
+
+    std::atomic<double> m_fixed_step{1e-5};
+    std::atomic<double> m_time_scale{1.0};
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_crossbar_mode{false};
+    std::atomic<uint64_t> m_schedule_generation{0};   // Bumped by every setting that restarts the schedule
+
+    // Worker-thread state
+    uint64_t m_steps = 0;
+    double m_time = 0.0;
+    double m_voltage = 0.0;
+
+    // Double-buffered snapshot: the worker fills m_snapshots[1 - m_front] and swaps
+    mutable std::mutex m_snapshot_mutex;
+    SimulationSnapshot m_snapshots[2];
+    int m_front = 0;
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    std::atomic<bool> m_quit{false};
+    std::thread m_thread;
+};
@@ -0,0 +1,96 @@
+#include "TiledMatrix.h"
+#include <algorithm>
+#include <chrono>
+
+TiledMatrix::TiledMatrix(int in_features, int out_features, int tile_rows, int tile_cols, size_t workers)
+    : TiledMatrix(in_features, out_features, tile_rows, tile_cols, std::make_shared<ThreadPool>(workers)) {}
+
+TiledMatrix::TiledMatrix(int in_features, int out_features, int tile_rows, int tile_cols, std::shared_ptr<ThreadPool> pool)
+    : m_in(std::max(1, in_features)), m_out(std::max(1, out_features)),
+      m_tile_rows(std::max(1, tile_rows)), m_tile_cols(std::max(1, tile_cols)),
+      m_pool(pool ? std::move(pool) : std::make_shared<ThreadPool>()) {
+    m_grid_rows = (m_in + m_tile_rows - 1) / m_tile_rows;
+    m_grid_cols = (m_out + m_tile_cols - 1) / m_tile_cols;
+    for (int t = 0; t < tile_count(); ++t) {
+        m_tiles.push_back(std::make_unique<Tile>(m_tile_rows, m_tile_cols));
+    }
+    m_latency_ms.assign(tile_count(), 0.0);
+}
+
+void TiledMatrix::set_params(const MemristorParams& p) {
+    for (auto& t : m_tiles) t->array.set_params(p);
+}
+
+void TiledMatrix::set_enable_ir_drop(bool val) {
+    for (auto& t : m_tiles) t->array.set_enable_ir_drop(val);
+}
+
+void TiledMatrix::set_r_wire(double r) {
+    for (auto& t : m_tiles) t->array.set_r_wire(r);
+}
+
+void TiledMatrix::set_solver_mode(NodalSolverMode mode) {
+    for (auto& t : m_tiles) t->array.set_solver_mode(mode);
+}
+
+void TiledMatrix::set_enable_dac(bool val) {
+    for (auto& t : m_tiles) t->array.set_enable_dac(val);
+}
+
+void TiledMatrix::set_dac_bits(int bits) {
+    for (auto& t : m_tiles) t->array.set_dac_bits(bits);
+}
+
+void TiledMatrix::set_enable_adc(bool val) {
+    for (auto& t : m_tiles) t->array.set_enable_adc(val);
+}
+
+void TiledMatrix::set_adc_bits(int bits) {
+    for (auto& t : m_tiles) t->array.set_adc_bits(bits);
+}
+
+void TiledMatrix::set_adc_range(double i_min, double i_max) {
+    for (auto& t : m_tiles) {
+        t->array.set_adc_i_min(i_min);
+        t->array.set_adc_i_max(i_max);
+    }
+}
+
+void TiledMatrix::forward_batch(const double* X, size_t batch, double* Y, double dt, bool read_only) {
+    const size_t tr_size = (size_t)m_tile_rows;
+    const size_t tc_size = (size_t)m_tile_cols;
+
+    // Every tile streams the whole batch; the tiles themselves are the unit of parallelism
+    m_pool->parallel_for((size_t)tile_count(), [&](size_t t, size_t) {
+        auto start = std::chrono::steady_clock::now();
+        Tile& tile = *m_tiles[t];
+        int tr = (int)t / m_grid_cols;
+        int k0 = tr * m_tile_rows;
+        int k_count = std::min(m_tile_rows, m_in - k0);
+
+        // Gather this tile's word-line slice; padded rows stay at 0 V
+        tile.x.assign(batch * tr_size, 0.0);
+        for (size_t b = 0; b < batch; ++b) {
+            std::copy_n(X + b * m_in + k0, k_count, &tile.x[b * tr_size]);
+        }
+        tile.partial.resize(batch * tc_size);
+        tile.array.forward_batch(tile.x.data(), batch, tile.partial.data(), dt, read_only);
+
+        m_latency_ms[t] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    });
+
+    // Digital accumulation of the per-tile ADC outputs along each tile column
+    std::fill(Y, Y + batch * (size_t)m_out, 0.0);
+    for (int tr = 0; tr < m_grid_rows; ++tr) {
+        for (int tc = 0; tc < m_grid_cols; ++tc) {
+            const Tile& tile = *m_tiles[(size_t)tr * m_grid_cols + tc];
+            int n0 = tc * m_tile_cols;
+            int n_count = std::min(m_tile_cols, m_out - n0);
+            for (size_t b = 0; b < batch; ++b) {
+                const double* part = &tile.partial[b * tc_size];
+                double* y = Y + b * m_out + n0;
+                for (int j = 0; j < n_count; ++j) y[j] += part[j];
+            }
+        }
+    }
+}
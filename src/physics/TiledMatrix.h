@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Crossbar.h"
+#include "../utils/ThreadPool.h"
+
+// Maps an arbitrary K x N weight matrix onto a grid of fixed-size crossbar tiles, the way a
+// CIM accelerator spreads one layer over many physical arrays. Tile (tr, tc) holds weight
+// rows [tr * tile_rows, ...) and columns [tc * tile_cols, ...); edge tiles are padded with
+// OFF cells and 0 V word lines, so every tile keeps its physical size and parasitics.
+//
+// forward_batch runs every tile over the whole batch in parallel on a ThreadPool. Each tile
+// digitizes its bitlines through its own ADC (quantize_adc) and the partial column sums are
+// then accumulated digitally, in fixed tile order so the result does not depend on timing.
+// Engines that run one after the other (a G+ / G- pair) should share one pool rather than
+// each starting a thread per core.
+class TiledMatrix {
+public:
+    TiledMatrix(int in_features, int out_features, int tile_rows = 64, int tile_cols = 64, size_t workers = 0);
+    TiledMatrix(int in_features, int out_features, int tile_rows, int tile_cols, std::shared_ptr<ThreadPool> pool);
+
+    int in_features() const { return m_in; }
+    int out_features() const { return m_out; }
+    int tile_rows() const { return m_tile_rows; }
+    int tile_cols() const { return m_tile_cols; }
+    int grid_rows() const { return m_grid_rows; }
+    int grid_cols() const { return m_grid_cols; }
+    int tile_count() const { return m_grid_rows * m_grid_cols; }
+
+    CrossbarArray& tile(int tr, int tc) { return m_tiles[(size_t)tr * m_grid_cols + tc]->array; }
+    const CrossbarArray& tile(int tr, int tc) const { return m_tiles[(size_t)tr * m_grid_cols + tc]->array; }
+
+    // Settings broadcast to every tile
+    void set_params(const MemristorParams& p);
+    void set_enable_ir_drop(bool val);
+    void set_r_wire(double r);
+    void set_solver_mode(NodalSolverMode mode);
+    void set_enable_dac(bool val);
+    void set_dac_bits(int bits);
+    void set_enable_adc(bool val);
+    void set_adc_bits(int bits);
+    void set_adc_range(double i_min, double i_max);
+
+    // Ideal programming from a row-major K x N weight matrix (values in [0, 1])
+    template <typename T>
+    void program_matrix(const T* weights) {
+        for (int tr = 0; tr < m_grid_rows; ++tr) {
+            for (int tc = 0; tc < m_grid_cols; ++tc) {
+                CrossbarArray& xbar = tile(tr, tc);
+                for (int i = 0; i < m_tile_rows; ++i) {
+                    int k = tr * m_tile_rows + i;
+                    for (int j = 0; j < m_tile_cols; ++j) {
+                        int n = tc * m_tile_cols + j;
+                        bool inside = k < m_in && n < m_out;
+                        xbar.program_cell(i, j, inside ? (double)weights[(size_t)k * m_out + n] : 0.0);
+                    }
+                }
+            }
+        }
+    }
+
+    // X is batch x K and Y is batch x N, both row-major
+    void forward_batch(const double* X, size_t batch, double* Y, double dt = 0.001, bool read_only = false);
+
+    // Wall-clock time of every tile's share of the last forward_batch, in milliseconds,
+    // indexed tr * grid_cols + tc
+    const std::vector<double>& tile_latency_ms() const { return m_latency_ms; }
+
+private:
+    struct Tile {
+        Tile(int rows, int cols) : array(rows, cols) {}
+        CrossbarArray array;
+        std::vector<double> x;        // batch x tile_rows slice of the input
+        std::vector<double> partial;  // batch x tile_cols digitized column currents
+    };
+
+    int m_in;
+    int m_out;
+    int m_tile_rows;
+    int m_tile_cols;
+    int m_grid_rows;
+    int m_grid_cols;
+    std::vector<std::unique_ptr<Tile>> m_tiles;
+    std::vector<double> m_latency_ms;
+    std::shared_ptr<ThreadPool> m_pool;
+};
@@ -1,7 +1,7 @@
 #include "Renderer.h"
 #include "Shader.h"
 #include "Camera.h"
-#include "physics/Crossbar.h"
+#include "physics/SimulationWorker.h"
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -126,7 +126,7 @@ void Renderer::draw_scene(const Camera& cam) {
     glDrawArrays(GL_TRIANGLES, 0, 36);
 }
 
-void Renderer::draw_crossbar(const Camera& cam, const CrossbarArray& array) {
+void Renderer::draw_crossbar(const Camera& cam, const SimulationSnapshot& state) {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -137,10 +137,13 @@ void Renderer::draw_crossbar(const Camera& cam, const CrossbarArray& array) {
     glm::vec3 lightPos(3.0f, 3.0f, 3.0f);
     glm::vec3 viewPos = glm::vec3(glm::inverse(view)[3]);
 
+    const int rows = state.rows;
+    const int cols = state.cols;
     float gridSpacing = 0.35f;
-    float startOffset = -3.5f * gridSpacing; // Center the 8x8 grid around 0
+    float rowOffset = -0.5f * (rows - 1) * gridSpacing; // Center the rows x cols grid around 0
+    float colOffset = -0.5f * (cols - 1) * gridSpacing;
 
-    // Draw Bottom Electrode Wires (8 horizontal bars running along X-axis)
+    // Draw Bottom Electrode Wires (one horizontal bar per row running along X-axis)
     shaderFilament.use();
     shaderFilament.setMat4("projection", projection);
     shaderFilament.setMat4("view", view);
@@ -151,34 +154,34 @@ void Renderer::draw_crossbar(const Camera& cam, const CrossbarArray& array) {
     shaderFilament.setVec3("u_ViewPos", viewPos);
     
     glBindVertexArray(cubeVAO);
-    for (int i = 0; i < 8; ++i) {
-        float z = startOffset + i * gridSpacing;
+    for (int i = 0; i < rows; ++i) {
+        float z = rowOffset + i * gridSpacing;
         glm::mat4 modelWire(1.0f);
         modelWire = glm::translate(modelWire, glm::vec3(0.0f, -0.17f, z));
-        modelWire = glm::scale(modelWire, glm::vec3(gridSpacing * 9.0f, 0.03f, 0.08f));
+        modelWire = glm::scale(modelWire, glm::vec3(gridSpacing * (cols + 1), 0.03f, 0.08f));
         shaderFilament.setMat4("model", modelWire);
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
-    // Draw Top Electrode Wires (8 vertical bars running along Z-axis)
+    // Draw Top Electrode Wires (one vertical bar per column running along Z-axis)
     shaderFilament.setVec3("u_Color", glm::vec3(1.0f, 0.78f, 0.15f)); // Gold
-    for (int j = 0; j < 8; ++j) {
-        float x = startOffset + j * gridSpacing;
+    for (int j = 0; j < cols; ++j) {
+        float x = colOffset + j * gridSpacing;
         glm::mat4 modelWire(1.0f);
         modelWire = glm::translate(modelWire, glm::vec3(x, 0.17f, 0.0f));
-        modelWire = glm::scale(modelWire, glm::vec3(0.08f, 0.03f, gridSpacing * 9.0f));
+        modelWire = glm::scale(modelWire, glm::vec3(0.08f, 0.03f, gridSpacing * (rows + 1)));
         shaderFilament.setMat4("model", modelWire);
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
-    // Draw 64 filaments at intersections
+    // Draw one filament per intersection
     glBindVertexArray(cylinderVAO);
-    for (int i = 0; i < 8; ++i) {
-        float z = startOffset + i * gridSpacing;
-        for (int j = 0; j < 8; ++j) {
-            float x = startOffset + j * gridSpacing;
-            double w_val = array.w(i, j);
-            double pow_val = array.power(i, j);
+    for (int i = 0; i < rows; ++i) {
+        float z = rowOffset + i * gridSpacing;
+        for (int j = 0; j < cols; ++j) {
+            float x = colOffset + j * gridSpacing;
+            double w_val = state.cell_w[(size_t)i * cols + j];
+            double pow_val = state.cell_power[(size_t)i * cols + j];
             
             float filamentRadius = 0.008f + (float)w_val * 0.045f;
             float visualHeat = std::min((float)(pow_val / 0.005), 1.0f);
@@ -209,7 +212,7 @@ void Renderer::draw_crossbar(const Camera& cam, const CrossbarArray& array) {
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glDepthMask(GL_TRUE);
 
-    // Draw 64 transparent oxide cubes at intersections
+    // Draw one transparent oxide cube per intersection
     shaderGlass.use();
     shaderGlass.setMat4("projection", projection);
     shaderGlass.setMat4("view", view);
@@ -217,10 +220,10 @@ void Renderer::draw_crossbar(const Camera& cam, const CrossbarArray& array) {
     shaderGlass.setVec4("u_Color", glm::vec4(0.0f, 0.6f, 0.8f, 0.07f));
     glBindVertexArray(cubeVAO);
     
-    for (int i = 0; i < 8; ++i) {
-        float z = startOffset + i * gridSpacing;
-        for (int j = 0; j < 8; ++j) {
-            float x = startOffset + j * gridSpacing;
+    for (int i = 0; i < rows; ++i) {
+        float z = rowOffset + i * gridSpacing;
+        for (int j = 0; j < cols; ++j) {
+            float x = colOffset + j * gridSpacing;
             glm::mat4 modelOx(1.0f);
             modelOx = glm::translate(modelOx, glm::vec3(x, 0.0f, z));
             modelOx = glm::scale(modelOx, glm::vec3(0.12f, 0.3f, 0.12f));
@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 #include "Shader.h"
 
+struct SimulationSnapshot;
+
 class Renderer {
 public:
     void init(int width, int height);
@@ -10,7 +12,7 @@ public:
     void begin_scene();
     void update_filament(double w, double power);
     void draw_scene(const class Camera& cam);
-    void draw_crossbar(const class Camera& cam, const class CrossbarArray& array);
+    void draw_crossbar(const class Camera& cam, const SimulationSnapshot& state);
     void end_scene();
     void shutdown();
     GLuint viewport_texture() const;
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// SplitMix64 finalizer: turns (seed, instance) into well-separated per-instance stream seeds
+static inline uint64_t mix_seed(uint64_t seed, uint64_t instance) {
+    uint64_t z = seed + (instance + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Independent noise sources of one device; each one is its own counter space
+enum class RngStream : uint32_t { D2D = 0, C2C = 1, RTN = 2, Read = 3 };
+
+// Counter-based generator (Philox4x32-10, Salmon et al., SC'11). A draw is a pure function of
+// (seed, device index, stream, counter): there is no sequential state to advance or copy, so
+// creating a stream for a million devices is free, any device's noise at any step can be
+// produced on any thread, and parallel runs are bit-identical to serial ones.
+//
+// Device indices are used up to 2^64 and counters up to 2^56 per stream.
+class CounterRng {
+public:
+    explicit CounterRng(uint64_t seed = NextDefaultSeed()) : m_seed(seed) {}
+
+    uint64_t seed() const { return m_seed; }
+    void set_seed(uint64_t s) { m_seed = s; }
+
+    // Two uniforms in (0, 1) from one Philox block
+    void uniform_pair(uint64_t device, RngStream stream, uint64_t counter, double& u0, double& u1) const {
+        uint32_t x[4];
+        block(device, stream, counter, x);
+        u0 = to_unit(x[0], x[1]);
+        u1 = to_unit(x[2], x[3]);
+    }
+
+    double uniform(uint64_t device, RngStream stream, uint64_t counter) const {
+        uint32_t x[4];
+        block(device, stream, counter, x);
+        return to_unit(x[0], x[1]);
+    }
+
+    // Two independent standard normals (Box-Muller on the Philox block of `index`)
+    void normal_pair(uint64_t index, RngStream stream, uint64_t counter, double& z0, double& z1) const {
+        double u0, u1;
+        uniform_pair(index, stream, counter, u0, u1);
+        double r = std::sqrt(-2.0 * std::log(u0));
+        z0 = r * std::cos(kTwoPi * u1);
+        z1 = r * std::sin(kTwoPi * u1);
+    }
+
+    // Per-device standard normal. Devices 2m and 2m+1 share one Philox block and take the
+    // cosine / sine half of its Box-Muller pair, which halves the cost of bulk generation.
+    double normal(uint64_t device, RngStream stream, uint64_t counter) const {
+        double u0, u1;
+        uniform_pair(device >> 1, stream, counter, u0, u1);
+        double r = std::sqrt(-2.0 * std::log(u0));
+        return (device & 1) ? r * std::sin(kTwoPi * u1) : r * std::cos(kTwoPi * u1);
+    }
+
+    // Bulk forms for vectorized noise injection: out[k] is the draw of device first_device + k
+    void fill_normals(uint64_t first_device, size_t count, RngStream stream, uint64_t counter, double* out) const {
+        size_t k = 0;
+        if (count > 0 && (first_device & 1)) {
+            out[0] = normal(first_device, stream, counter);
+            k = 1;
+        }
+        for (; k + 1 < count; k += 2) normal_pair((first_device + k) >> 1, stream, counter, out[k], out[k + 1]);
+        if (k < count) out[k] = normal(first_device + k, stream, counter);
+    }
+
+    void fill_uniforms(uint64_t first_device, size_t count, RngStream stream, uint64_t counter, double* out) const {
+        for (size_t k = 0; k < count; ++k) out[k] = uniform(first_device + k, stream, counter);
+    }
+
+    // Raw Philox4x32-10 block for a 128-bit counter and 64-bit key
+    static void Philox(const uint32_t ctr[4], uint64_t key, uint32_t out[4]) {
+        uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+        uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1;
+            c3 = (uint32_t)p0;
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    // Seeds for generators that are not given one: mix_seed(global seed, construction index).
+    // Runs are reproducible as long as engines are constructed in the same order.
+    static uint64_t NextDefaultSeed() { return mix_seed(s_global_seed.load(), s_instances.fetch_add(1)); }
+    static void SetGlobalSeed(uint64_t s) {
+        s_global_seed.store(s);
+        s_instances.store(0);
+    }
+
+private:
+    static constexpr double kTwoPi = 6.283185307179586;
+
+    void block(uint64_t device, RngStream stream, uint64_t counter, uint32_t out[4]) const {
+        uint32_t ctr[4] = {(uint32_t)device, (uint32_t)(device >> 32), (uint32_t)counter,
+                           (uint32_t)((counter >> 32) & 0x00FFFFFFu) | ((uint32_t)stream << 24)};
+        Philox(ctr, m_seed, out);
+    }
+
+    // 53 random bits mapped to the open interval (0, 1), so log(u) is always finite
+    static double to_unit(uint32_t hi, uint32_t lo) {
+        uint64_t bits = (((uint64_t)hi << 32) | lo) >> 11;
+        return ((double)bits + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    uint64_t m_seed;
+
+    static inline std::atomic<uint64_t> s_global_seed{0x5EED};
+    static inline std::atomic<uint64_t> s_instances{0};
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer / single-consumer queue. push() and pop() are wait-free: each side
+// owns one index and only reads the other's with acquire ordering, so neither ever blocks or
+// allocates. When the ring is full push() fails and the caller decides what to drop.
+// T must be trivially copyable; the capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        m_items.resize(n);
+        m_mask = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return m_items.size(); }
+
+    // Producer side
+    bool push(const T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail_cache == m_items.size()) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+            if (head - m_tail_cache == m_items.size()) return false;
+        }
+        m_items[head & m_mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Items pushed since construction; any thread, a lower bound while the producer runs
+    size_t pushed() const { return m_head.load(std::memory_order_acquire); }
+
+    // Consumer side: moves up to max items into out, oldest first, and returns the count
+    size_t pop(T* out, size_t max) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head_cache == tail) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (m_head_cache == tail) return 0;
+        }
+        size_t n = m_head_cache - tail;
+        if (n > max) n = max;
+        for (size_t k = 0; k < n; ++k) out[k] = m_items[(tail + k) & m_mask];
+        m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    std::vector<T> m_items;
+    size_t m_mask = 0;
+    // Producer and consumer indices (and each side's cached view of the other) on separate
+    // cache lines, so the two threads do not false-share
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_tail_cache = 0;
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_head_cache = 0;
+};
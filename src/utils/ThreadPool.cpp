@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t w = 0; w < threads; ++w) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t w = 0; w < threads; ++w) {
+        m_threads.emplace_back(&ThreadPool::worker_loop, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_threads) t.join();
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn, size_t grain) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> submit(m_submit);
+
+    grain = std::max<size_t>(1, grain);
+    size_t chunks = (count + grain - 1) / grain;
+
+    // The count must be in place before the first chunk is visible: a worker still in its
+    // take() loop from the previous call can pick up and finish a new chunk straight away.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = chunks;
+    }
+    for (size_t c = 0; c < chunks; ++c) {
+        WorkQueue& q = *m_queues[c % m_queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.chunks.push_back({&fn, c * grain, std::min(count, (c + 1) * grain)});
+    }
+
+    // Wake sleeping workers only once every chunk is queued, so none finds the deques empty
+    // and goes back to sleep on the new generation
+    std::unique_lock<std::mutex> lock(m_mutex);
+    ++m_generation;
+    m_wake.notify_all();
+    m_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+bool ThreadPool::take(size_t worker, Chunk& chunk) {
+    // Own deque first (LIFO keeps recently dealt chunks hot), then steal the oldest elsewhere
+    {
+        WorkQueue& own = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.chunks.empty()) {
+            chunk = own.chunks.back();
+            own.chunks.pop_back();
+            return true;
+        }
+    }
+    size_t n = m_queues.size();
+    for (size_t k = 1; k < n; ++k) {
+        WorkQueue& victim = *m_queues[(worker + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+        }
+
+        // Chunks carry their own job, so a worker that wakes late can never run a stale callback
+        Chunk chunk;
+        while (take(worker, chunk)) {
+            for (size_t i = chunk.begin; i < chunk.end; ++i) (*chunk.job)(i, worker);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) m_done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing index ranges with work stealing. parallel_for splits
+// [0, count) into chunks of `grain` indices and deals them round-robin onto per-worker deques;
+// each worker drains its own deque from the back and, once empty, steals from the front of
+// the others, so uneven per-index cost still balances across cores.
+// The callback receives the worker number as well, which lets callers keep per-worker
+// scratch state (e.g. one CrossbarArray replica per thread). Calls must not be nested.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return m_threads.size(); }
+
+    // Runs fn(index, worker) for every index in [0, count) and blocks until all are done.
+    void parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn, size_t grain = 1);
+
+private:
+    struct Chunk {
+        const std::function<void(size_t, size_t)>* job;
+        size_t begin;
+        size_t end;
+    };
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    void worker_loop(size_t worker);
+    bool take(size_t worker, Chunk& chunk);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    std::mutex m_submit;   // Serializes concurrent parallel_for callers
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    size_t m_pending = 0;
+    bool m_stop = false;
+};
@@ -0,0 +1,308 @@
+#include "TraceFile.h"
+#include "ThreadPool.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Binary cache header: magic, format version, row count; the t, v and i columns follow
+static const char kMagic[8] = {'M', 'T', 'R', 'A', 'C', 'E', '\0', '\0'};
+static const uint32_t kVersion = 1;
+static const size_t kHeaderBytes = 8 + 4 + 4 + 8;
+
+// Chunks smaller than this are not worth a worker
+static const size_t kMinChunkBytes = 1 << 20;
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size)) return;
+        m_size = (size_t)size.QuadPart;
+        m_open = true;
+        if (m_size == 0) return;
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) { m_open = false; return; }
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data) m_open = false;
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) return;
+        struct stat st;
+        if (fstat(m_fd, &st) != 0) return;
+        m_size = (size_t)st.st_size;
+        m_open = true;
+        if (m_size == 0) return;
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (p == MAP_FAILED) { m_open = false; return; }
+        madvise(p, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(p);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+        if (m_data) munmap(const_cast<char*>(m_data), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return m_open; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+};
+
+// Rows of one chunk. implicit_t marks Voltage,Current rows, whose time is only known once
+// every earlier chunk has been parsed.
+struct ParsedChunk {
+    TraceColumns rows;
+    std::vector<uint8_t> implicit_t;
+    bool any_implicit = false;
+};
+
+// Parses one field the way std::stod would: leading whitespace and a '+' sign are accepted and
+// trailing characters ignored. Returns false for non-numeric fields.
+static bool parse_field(const char* p, const char* end, double& value) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) ++p;
+    if (p < end && *p == '+') ++p;
+    auto res = std::from_chars(p, end, value);
+    return res.ec == std::errc() && res.ptr != p;
+}
+
+// Parses the complete lines in [p, end)
+static void parse_chunk(const char* p, const char* end, ParsedChunk& chunk) {
+    size_t estimate = (size_t)(end - p) / 24;
+    chunk.rows.t.reserve(estimate);
+    chunk.rows.v.reserve(estimate);
+    chunk.rows.i.reserve(estimate);
+    chunk.implicit_t.reserve(estimate);
+
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        if (!line_end) line_end = end;
+
+        double vals[3];
+        int count = 0;
+        const char* field = p;
+        while (count < 3 && field <= line_end) {
+            const char* comma = static_cast<const char*>(std::memchr(field, ',', (size_t)(line_end - field)));
+            const char* field_end = comma ? comma : line_end;
+            if (parse_field(field, field_end, vals[count])) ++count;
+            if (!comma) break;
+            field = comma + 1;
+        }
+
+        if (count == 3) {
+            chunk.rows.t.push_back(vals[0]);
+            chunk.rows.v.push_back(vals[1]);
+            chunk.rows.i.push_back(vals[2]);
+            chunk.implicit_t.push_back(0);
+        } else if (count == 2) {
+            chunk.rows.t.push_back(0.0);
+            chunk.rows.v.push_back(vals[0]);
+            chunk.rows.i.push_back(vals[1]);
+            chunk.implicit_t.push_back(1);
+            chunk.any_implicit = true;
+        }
+        p = line_end + 1;
+    }
+}
+
+bool TraceFile::LoadCSV(const std::string& path, TraceColumns& out, std::string& err, size_t threads) {
+    out = TraceColumns();
+    MappedFile file(path);
+    if (!file.is_open()) {
+        err = "Could not open file: " + path;
+        return false;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if (file.size() == 0) {
+        err = "Empty file: " + path;
+        return false;
+    }
+
+    // Skip the header line
+    const char* body = static_cast<const char*>(std::memchr(begin, '\n', file.size()));
+    body = body ? body + 1 : end;
+
+    // Split the body at line boundaries
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t body_bytes = (size_t)(end - body);
+    size_t chunks = (threads == 1) ? 1 : std::max<size_t>(1, std::min(threads * 4, body_bytes / kMinChunkBytes));
+    std::vector<const char*> bounds(chunks + 1, end);
+    bounds[0] = body;
+    for (size_t c = 1; c < chunks; ++c) {
+        const char* p = std::max(bounds[c - 1], body + body_bytes / chunks * c);
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        bounds[c] = nl ? nl + 1 : end;
+    }
+
+    std::vector<ParsedChunk> parsed(chunks);
+    if (chunks == 1) {
+        for (size_t c = 0; c < chunks; ++c) parse_chunk(bounds[c], bounds[c + 1], parsed[c]);
+    } else {
+        ThreadPool pool(std::min(threads, chunks));
+        pool.parallel_for(chunks, [&](size_t c, size_t) { parse_chunk(bounds[c], bounds[c + 1], parsed[c]); });
+    }
+
+    size_t rows = 0;
+    for (const ParsedChunk& c : parsed) rows += c.rows.size();
+    out.resize(rows);
+
+    // Merge in file order. Voltage,Current rows continue from the last explicit time in 10 ms
+    // steps, which is resolved here since it runs across chunk boundaries.
+    size_t at = 0;
+    double last_t = 0.0;
+    for (ParsedChunk& c : parsed) {
+        size_t n = c.rows.size();
+        std::copy(c.rows.v.begin(), c.rows.v.end(), out.v.begin() + at);
+        std::copy(c.rows.i.begin(), c.rows.i.end(), out.i.begin() + at);
+        if (c.any_implicit) {
+            for (size_t k = 0; k < n; ++k) {
+                if (c.implicit_t[k]) {
+                    out.t[at + k] = last_t;
+                    last_t += 0.01;
+                } else {
+                    out.t[at + k] = last_t = c.rows.t[k];
+                }
+            }
+        } else if (n > 0) {
+            std::copy(c.rows.t.begin(), c.rows.t.end(), out.t.begin() + at);
+            last_t = c.rows.t[n - 1];
+        }
+        at += n;
+        c = ParsedChunk();
+    }
+
+    if (rows == 0) {
+        err = "No data parsed. Requires Time,Voltage,Current or Voltage,Current.";
+        return false;
+    }
+    return true;
+}
+
+bool TraceFile::IsBinary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool TraceFile::SaveBinary(const std::string& path, const TraceColumns& trace, std::string& err) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        err = "Could not write file: " + path;
+        return false;
+    }
+    uint32_t reserved = 0;
+    uint64_t rows = trace.size();
+    file.write(kMagic, sizeof(kMagic));
+    file.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+    file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    for (const std::vector<double>* col : {&trace.t, &trace.v, &trace.i}) {
+        file.write(reinterpret_cast<const char*>(col->data()), (std::streamsize)(rows * sizeof(double)));
+    }
+    if (!file) {
+        err = "Could not write file: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TraceFile::LoadBinary(const std::string& path, TraceColumns& out, std::string& err) {
+    // Read straight into the columns: mapping the file would keep a second resident copy of
+    // every page until it is unmapped
+    out = TraceColumns();
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        err = "Could not open file: " + path;
+        return false;
+    }
+    char header[kHeaderBytes] = {};
+    uint32_t version = 0;
+    uint64_t rows = 0;
+    if (!file.read(header, sizeof(header)) || std::memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        err = "Not a trace cache file: " + path;
+        return false;
+    }
+    std::memcpy(&version, header + 8, sizeof(version));
+    std::memcpy(&rows, header + 16, sizeof(rows));
+    std::error_code ec;
+    uint64_t size = (uint64_t)fs::file_size(path, ec);
+    if (version != kVersion || ec || size != kHeaderBytes + rows * 3 * sizeof(double)) {
+        err = "Unsupported or truncated trace cache file: " + path;
+        return false;
+    }
+    out.resize((size_t)rows);
+    for (std::vector<double>* dst : {&out.t, &out.v, &out.i}) {
+        if (!file.read(reinterpret_cast<char*>(dst->data()), (std::streamsize)(rows * sizeof(double)))) {
+            out = TraceColumns();
+            err = "Unsupported or truncated trace cache file: " + path;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TraceFile::Load(const std::string& path, TraceColumns& out, std::string& err, const TraceLoadOptions& options) {
+    if (IsBinary(path)) return LoadBinary(path, out, err);
+    if (TraceRecorder::IsRecording(path)) return TraceRecorder::LoadColumns(path, out, err);
+    if (!options.use_cache) return LoadCSV(path, out, err, options.threads);
+
+    std::string cache = CachePath(path);
+    std::error_code ec;
+    auto csv_time = fs::last_write_time(path, ec);
+    if (!ec) {
+        auto cache_time = fs::last_write_time(cache, ec);
+        std::string cache_err;
+        if (!ec && cache_time >= csv_time && LoadBinary(cache, out, cache_err)) return true;
+    }
+    if (!LoadCSV(path, out, err, options.threads)) return false;
+    // A cache that cannot be written (read-only data directory) only costs the next load
+    std::string cache_err;
+    SaveBinary(cache, out, cache_err);
+    return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Columnar I-V characterization trace: sample times, applied voltages and measured currents
+struct TraceColumns {
+    std::vector<double> t;
+    std::vector<double> v;
+    std::vector<double> i;
+
+    size_t size() const { return t.size(); }
+    bool empty() const { return t.empty(); }
+    void resize(size_t n) {
+        t.resize(n);
+        v.resize(n);
+        i.resize(n);
+    }
+};
+
+struct TraceLoadOptions {
+    size_t threads = 1;        // Parse the CSV in this many chunks concurrently (0 = all cores)
+    bool use_cache = false;    // Read / refresh the binary cache CachePath(csv) next to the CSV
+};
+
+// Loader for measured pulse traces. The CSV is memory-mapped and parsed in place with
+// std::from_chars straight into TraceColumns, without per-line strings or exceptions; large
+// files can be split at line boundaries into chunks parsed on a ThreadPool. The accepted
+// format is MemristorFitter's: a header line, then Time,Voltage,Current rows (extra columns
+// ignored) or Voltage,Current rows, whose time advances 10 ms per row from the last explicit
+// one. Non-numeric fields are skipped.
+//
+// The binary cache is the three columns as raw little-endian doubles behind a small header,
+// so reloading it is one read per column into its final buffer.
+class TraceFile {
+public:
+    static bool LoadCSV(const std::string& path, TraceColumns& out, std::string& err, size_t threads = 1);
+    static bool SaveBinary(const std::string& path, const TraceColumns& trace, std::string& err);
+    static bool LoadBinary(const std::string& path, TraceColumns& out, std::string& err);
+    // True when the file starts with the binary cache header
+    static bool IsBinary(const std::string& path);
+
+    // Binary caches and TraceRecorder recordings are recognized by their header and everything
+    // else is parsed as CSV. With options.use_cache a CSV is read from its cache when that is
+    // at least as new as the CSV, and the cache is (re)written after parsing otherwise.
+    static bool Load(const std::string& path, TraceColumns& out, std::string& err,
+                     const TraceLoadOptions& options = TraceLoadOptions());
+
+    static std::string CachePath(const std::string& csv_path) { return csv_path + ".mtrace"; }
+};
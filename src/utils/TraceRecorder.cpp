@@ -0,0 +1,307 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+// Recording header: magic, format version, doubles per sample; chunks follow
+static const char kMagic[8] = {'M', 'T', 'R', 'E', 'C', '\0', '\0', '\0'};
+static const uint32_t kVersion = 1;
+static constexpr uint32_t kFields = sizeof(TraceSample) / sizeof(double);
+
+// Largest chunk a reader accepts, so a corrupt count cannot ask for gigabytes
+static const uint32_t kMaxChunkSamples = 1u << 24;
+
+// How long the writer sleeps when the ring is empty, and how often a partial chunk is written
+static const std::chrono::milliseconds kPollInterval(2);
+static const std::chrono::seconds kFlushInterval(1);
+
+TraceRecorder::TraceRecorder(size_t recent_samples, size_t ring_capacity)
+    : m_ring(ring_capacity), m_recent_max(recent_samples > 0 ? recent_samples : 1) {
+    m_recent.reserve(m_recent_max);
+    m_chunk.reserve(kChunkSamples);
+    m_writer = std::thread(&TraceRecorder::writer_loop, this);
+}
+
+TraceRecorder::~TraceRecorder() {
+    stop_recording();
+    {
+        std::lock_guard<std::mutex> lock(m_file_mutex);
+        m_quit.store(true);
+    }
+    m_file_cv.notify_all();
+    if (m_writer.joinable()) m_writer.join();
+    if (m_export_thread.joinable()) m_export_thread.join();
+}
+
+bool TraceRecorder::start_recording(const std::string& path, std::string& err) {
+    stop_recording();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        err = "Could not write file: " + path;
+        set_error(err);
+        return false;
+    }
+    uint32_t fields = kFields;
+    std::fwrite(kMagic, 1, sizeof(kMagic), file);
+    std::fwrite(&kVersion, sizeof(kVersion), 1, file);
+    if (std::fwrite(&fields, sizeof(fields), 1, file) != 1 || std::fflush(file) != 0) {
+        std::fclose(file);
+        err = "Could not write file: " + path;
+        set_error(err);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_file_mutex);
+    m_file = file;
+    m_path = path;
+    m_start_at = m_ring.pushed();
+    m_chunk.clear();
+    m_recorded.store(0);
+    m_recording.store(true, std::memory_order_release);
+    set_error("");
+    return true;
+}
+
+void TraceRecorder::stop_recording() {
+    std::unique_lock<std::mutex> lock(m_file_mutex);
+    if (!m_file) return;
+    m_stop_requested = true;
+    m_stop_at = m_ring.pushed();
+    m_file_cv.notify_all();
+    m_file_cv.wait(lock, [this] { return !m_stop_requested; });
+}
+
+std::string TraceRecorder::recording_path() const {
+    std::lock_guard<std::mutex> lock(m_file_mutex);
+    return m_path;
+}
+
+void TraceRecorder::recent(std::vector<TraceSample>& out) const {
+    std::lock_guard<std::mutex> lock(m_recent_mutex);
+    out.resize(m_recent.size());
+    size_t head = m_recent.size() - m_recent_offset;
+    std::copy(m_recent.begin() + m_recent_offset, m_recent.end(), out.begin());
+    std::copy(m_recent.begin(), m_recent.begin() + m_recent_offset, out.begin() + head);
+}
+
+void TraceRecorder::clear_recent() {
+    std::lock_guard<std::mutex> lock(m_recent_mutex);
+    m_recent.clear();
+    m_recent_offset = 0;
+}
+
+std::string TraceRecorder::last_error() const {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    return m_error;
+}
+
+void TraceRecorder::set_error(const std::string& err) {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_error = err;
+}
+
+void TraceRecorder::flush_chunk() {
+    if (!m_file || m_chunk.empty()) return;
+    uint32_t header[2] = {(uint32_t)m_chunk.size(), 0};
+    bool ok = std::fwrite(header, sizeof(header), 1, m_file) == 1 &&
+              std::fwrite(m_chunk.data(), sizeof(TraceSample), m_chunk.size(), m_file) == m_chunk.size() &&
+              std::fflush(m_file) == 0;
+    m_chunk.clear();
+    if (!ok) {
+        // Disk full or similar: keep what made it to disk and stop recording
+        set_error("Could not write file: " + m_path);
+        std::fclose(m_file);
+        m_file = nullptr;
+        m_recording.store(false, std::memory_order_release);
+    }
+}
+
+void TraceRecorder::writer_loop() {
+    std::vector<TraceSample> batch(kChunkSamples);
+    auto last_flush = std::chrono::steady_clock::now();
+    size_t consumed = 0;   // Ring position of the next sample to pop
+    for (;;) {
+        size_t first = consumed;
+        size_t n = m_ring.pop(batch.data(), batch.size());
+        consumed += n;
+
+        if (n > 0) {
+            size_t stride = m_recent_stride.load(std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(m_recent_mutex);
+            for (size_t k = 0; k < n; ++k) {
+                if (++m_recent_skip < stride) continue;
+                m_recent_skip = 0;
+                if (m_recent.size() < m_recent_max) {
+                    m_recent.push_back(batch[k]);
+                } else {
+                    m_recent[m_recent_offset] = batch[k];
+                    m_recent_offset = (m_recent_offset + 1) % m_recent_max;
+                }
+            }
+        }
+
+        // The recording bounds are read under the same lock as m_file, so a start or stop that
+        // lands while this batch was popped still applies to it
+        std::unique_lock<std::mutex> lock(m_file_mutex);
+        const bool stop_pending = m_stop_requested;
+        if (m_file) {
+            // Only the samples pushed between start_recording() and the stop request belong in
+            // the file; ones still queued from before the start are skipped
+            size_t skip = std::min(n, m_start_at > first ? m_start_at - first : 0);
+            size_t keep = stop_pending ? std::min(n, m_stop_at > first ? m_stop_at - first : 0) : n;
+            for (size_t k = skip; k < keep && m_file; ++k) {
+                m_chunk.push_back(batch[k]);
+                if (m_chunk.size() == kChunkSamples) flush_chunk();
+            }
+            m_recorded.fetch_add(keep > skip ? keep - skip : 0, std::memory_order_relaxed);
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_flush >= kFlushInterval) {
+                flush_chunk();
+                last_flush = now;
+            }
+        }
+        // Close as soon as the writer is past the position the producer had reached when
+        // stop_recording() was called, even if the simulation keeps the ring busy
+        if (stop_pending && consumed >= m_stop_at) {
+            flush_chunk();
+            if (m_file) std::fclose(m_file);
+            m_file = nullptr;
+            m_recording.store(false, std::memory_order_release);
+            m_stop_requested = false;
+            m_file_cv.notify_all();
+            continue;
+        }
+        if (n == 0) {
+            if (m_quit.load()) break;
+            m_file_cv.wait_for(lock, kPollInterval, [this] { return m_stop_requested || m_quit.load(); });
+        }
+    }
+}
+
+using CsvFile = std::unique_ptr<FILE, int (*)(FILE*)>;
+
+static CsvFile open_csv(const std::string& path, std::string& err) {
+    CsvFile file(std::fopen(path.c_str(), "wb"), &std::fclose);
+    if (!file) {
+        err = "Could not write file: " + path;
+        return file;
+    }
+    static const char kHeader[] = "Time,Voltage,Current,Resistance,State,DeltaT\n";
+    std::fwrite(kHeader, 1, sizeof(kHeader) - 1, file.get());
+    return file;
+}
+
+// Shortest round-trip formatting, one buffered write per call
+static void write_csv_rows(FILE* file, const TraceSample* s, size_t n) {
+    std::vector<char> text(n * kFields * 32);
+    char* p = text.data();
+    char* end = p + text.size();
+    for (size_t k = 0; k < n; ++k) {
+        const double fields[kFields] = {s[k].t, s[k].v, s[k].i, s[k].r, s[k].w, s[k].dT};
+        for (uint32_t c = 0; c < kFields; ++c) {
+            p = std::to_chars(p, end, fields[c]).ptr;
+            *p++ = (c + 1 < kFields) ? ',' : '\n';
+        }
+    }
+    std::fwrite(text.data(), 1, (size_t)(p - text.data()), file);
+}
+
+static bool close_csv(CsvFile file, const std::string& path, std::string& err) {
+    bool ok = !std::ferror(file.get());
+    ok = (std::fclose(file.release()) == 0) && ok;
+    if (!ok) err = "Could not write file: " + path;
+    return ok;
+}
+
+static bool write_csv(const std::string& path, const TraceSample* s, size_t n, std::string& err) {
+    CsvFile file = open_csv(path, err);
+    if (!file) return false;
+    write_csv_rows(file.get(), s, n);
+    return close_csv(std::move(file), path, err);
+}
+
+bool TraceRecorder::export_csv(const std::string& csv_path) {
+    if (m_exporting.exchange(true)) return false;
+    if (m_export_thread.joinable()) m_export_thread.join();
+
+    std::string source;
+    if (recorded() > 0) source = recording_path();
+    auto window = std::make_shared<std::vector<TraceSample>>();
+    if (source.empty()) recent(*window);
+
+    m_export_thread = std::thread([this, source, window, csv_path] {
+        std::string err;
+        bool ok = source.empty() ? write_csv(csv_path, window->data(), window->size(), err)
+                                 : ExportCSV(source, csv_path, err);
+        set_error(ok ? "" : err);
+        m_exporting.store(false, std::memory_order_release);
+    });
+    return true;
+}
+
+bool TraceRecorder::IsRecording(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char magic[sizeof(kMagic)] = {};
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+bool TraceRecorder::ReadRecording(const std::string& path,
+                                  const std::function<void(const TraceSample*, size_t)>& on_chunk, std::string& err) {
+    std::unique_ptr<FILE, int (*)(FILE*)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (!file) {
+        err = "Could not open file: " + path;
+        return false;
+    }
+    char magic[sizeof(kMagic)] = {};
+    uint32_t version = 0, fields = 0;
+    if (std::fread(magic, 1, sizeof(magic), file.get()) != sizeof(magic) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        std::fread(&version, sizeof(version), 1, file.get()) != 1 || std::fread(&fields, sizeof(fields), 1, file.get()) != 1) {
+        err = "Not a trace recording: " + path;
+        return false;
+    }
+    if (version != kVersion || fields != kFields) {
+        err = "Unsupported trace recording: " + path;
+        return false;
+    }
+
+    // A chunk cut short (recording still running, or the process died mid-write) ends the
+    // recording; everything before it is intact
+    std::vector<TraceSample> chunk;
+    uint32_t header[2];
+    while (std::fread(header, sizeof(header), 1, file.get()) == 1) {
+        if (header[0] == 0 || header[0] > kMaxChunkSamples) break;
+        chunk.resize(header[0]);
+        if (std::fread(chunk.data(), sizeof(TraceSample), chunk.size(), file.get()) != chunk.size()) break;
+        on_chunk(chunk.data(), chunk.size());
+    }
+    return true;
+}
+
+bool TraceRecorder::LoadColumns(const std::string& path, TraceColumns& out, std::string& err) {
+    out = TraceColumns();
+    bool ok = ReadRecording(path, [&](const TraceSample* s, size_t n) {
+        for (size_t k = 0; k < n; ++k) {
+            out.t.push_back(s[k].t);
+            out.v.push_back(s[k].v);
+            out.i.push_back(s[k].i);
+        }
+    }, err);
+    if (ok && out.size() == 0) {
+        err = "Empty trace recording: " + path;
+        return false;
+    }
+    return ok;
+}
+
+bool TraceRecorder::ExportCSV(const std::string& recording_path, const std::string& csv_path, std::string& err) {
+    CsvFile file = open_csv(csv_path, err);
+    if (!file) return false;
+    if (!ReadRecording(recording_path, [&](const TraceSample* s, size_t n) { write_csv_rows(file.get(), s, n); }, err))
+        return false;
+    return close_csv(std::move(file), csv_path, err);
+}
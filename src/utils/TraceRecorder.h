@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+#include "TraceFile.h"
+
+// One simulation step as seen by the oscilloscope
+struct TraceSample {
+    double t;    // Simulation time (s)
+    double v;    // Applied voltage (V)
+    double i;    // Cell current (A)
+    double r;    // Resistance (Ohm)
+    double w;    // State variable
+    double dT;   // Temperature rise above ambient (K)
+};
+
+// Streaming recorder for device traces. The simulation thread push()es samples into a fixed
+// SpscRing and never waits: when the ring is full the sample is dropped and counted. A writer
+// thread drains the ring every few milliseconds into
+//   - a chronological window of the latest recent_samples samples for the plot (recent(),
+//     optionally decimated by set_recent_stride()), and
+//   - while recording, a chunked binary file written a chunk at a time.
+// Memory use is the ring, the window and one chunk, however long a recording runs.
+//
+// Recording file: an 8-byte magic, format version and field count (u32 each), then chunks of
+// a u32 sample count, a reserved u32 and that many TraceSamples as little-endian doubles.
+// A chunk is written when full and at least once a second, so a crash loses at most the last
+// second and every complete chunk stays readable. ExportCSV() converts a recording to CSV
+// (Time,Voltage,Current,Resistance,State,DeltaT), which MemristorFitter and TraceFile read.
+class TraceRecorder {
+public:
+    static constexpr size_t kChunkSamples = 4096;
+
+    explicit TraceRecorder(size_t recent_samples = 4000, size_t ring_capacity = 1 << 16);
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Simulation thread only. Returns false when the ring was full and the sample dropped.
+    bool push(const TraceSample& s) {
+        if (m_ring.push(s)) return true;
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Starts writing every sample pushed from now on to path, replacing the file
+    bool start_recording(const std::string& path, std::string& err);
+    // Returns once every sample pushed before the call is on disk and the file is closed
+    void stop_recording();
+    bool recording() const { return m_recording.load(std::memory_order_acquire); }
+    // Path of the current or last recording ("" before the first one)
+    std::string recording_path() const;
+    // Samples written to the current or last recording
+    uint64_t recorded() const { return m_recorded.load(std::memory_order_relaxed); }
+    // Samples lost to a full ring since construction
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Copies the display window, oldest sample first
+    void recent(std::vector<TraceSample>& out) const;
+    void clear_recent();
+    // Keep only every n-th sample in the display window, so it spans the same wall time at
+    // high step rates. Recordings always keep every sample.
+    void set_recent_stride(size_t n) { m_recent_stride.store(n > 0 ? n : 1, std::memory_order_relaxed); }
+
+    // Writes the current or last recording (what is on disk so far), or the display window if
+    // nothing has been recorded, to csv_path on a background thread. Returns false while a
+    // previous export is still running.
+    bool export_csv(const std::string& csv_path);
+    bool exporting() const { return m_exporting.load(std::memory_order_acquire); }
+    // Error of the last failed start_recording / export ("" when it succeeded)
+    std::string last_error() const;
+
+    static bool IsRecording(const std::string& path);
+    // Calls on_chunk for every complete chunk of a recording, in order
+    static bool ReadRecording(const std::string& path,
+                              const std::function<void(const TraceSample*, size_t)>& on_chunk, std::string& err);
+    // The t, v and i columns of a recording, for fitting
+    static bool LoadColumns(const std::string& path, TraceColumns& out, std::string& err);
+    static bool ExportCSV(const std::string& recording_path, const std::string& csv_path, std::string& err);
+
+private:
+    void writer_loop();
+    void flush_chunk();   // Caller holds m_file_mutex
+    void set_error(const std::string& err);
+
+    SpscRing<TraceSample> m_ring;
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Display window, filled by the writer thread
+    mutable std::mutex m_recent_mutex;
+    std::vector<TraceSample> m_recent;
+    size_t m_recent_max;
+    size_t m_recent_offset = 0;
+    std::atomic<size_t> m_recent_stride{1};
+    size_t m_recent_skip = 0;   // Samples since the last one kept; writer thread only
+
+    // Recording state, shared by the writer thread and start/stop
+    mutable std::mutex m_file_mutex;
+    std::condition_variable m_file_cv;
+    FILE* m_file = nullptr;
+    std::string m_path;
+    std::vector<TraceSample> m_chunk;
+    std::atomic<bool> m_recording{false};
+    std::atomic<uint64_t> m_recorded{0};
+    bool m_stop_requested = false;   // Set by stop_recording, cleared by the writer once closed
+    size_t m_start_at = 0;           // Ring position at start_recording; the file begins there
+    size_t m_stop_at = 0;            // Ring position at the stop request; the file ends there
+
+    std::atomic<bool> m_exporting{false};
+    std::thread m_export_thread;
+    mutable std::mutex m_error_mutex;
+    std::string m_error;
+
+    std::atomic<bool> m_quit{false};
+    std::thread m_writer;
+};
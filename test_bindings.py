@@ -81,4 +81,19 @@ for r_w in [0.0, 1.0, 2.0, 5.0, 10.0]:
     crossbar.update(0.001)
     print(f"  r_wire = {r_w:4.1f} Ohm -> I_BL[0] = {crossbar.outputs()[0]:.6f} A")
 
+# Bulk programming and batched reads from NumPy
+print("\n--- 3. Testing bulk programming and batched VMM ---")
+import numpy as np
+crossbar.set_enable_ir_drop(False)
+weights = np.eye(8, dtype=np.float32)
+crossbar.program_matrix(weights)
+print(f"Programmed identity matrix: w[3][3] = {crossbar.w(3, 3):.2f}, w[3][4] = {crossbar.w(3, 4):.2f}")
+
+batch = np.random.rand(16, 8)
+currents = crossbar.forward_batch(batch, 0.001, read_only=True)
+print(f"forward_batch output shape: {currents.shape}")
+
+pulses, energy = crossbar.program_matrix_write_verify(np.full((8, 8), 0.5), tolerance=0.01)
+print(f"Write-verified all cells to w=0.5 in {pulses} pulses, {energy*1e6:.1f} uJ")
+
 print("\nAll python binding checks completed successfully!")
@@ -0,0 +1,40 @@
+// MonteCarloEnsemble::run_crossbars must give the same result for any worker count, including
+// with an adaptive integrator whose step size a replica carries from instance to instance
+#include <cstdio>
+#include <vector>
+#include "physics/MonteCarloEnsemble.h"
+
+int main() {
+    CrossbarArray prototype(4, 4);
+    MemristorParams p = prototype.params();
+    p.integrator = IntegratorMode::DormandPrince;
+    p.enable_variability = true;
+    prototype.set_params(p);
+
+    WaveformGenerator waveform;
+    waveform.set_waveform(Waveform::DC);
+    waveform.set_amplitude(1.2);
+
+    EnsembleConfig config;
+    config.instances = 64;
+    config.duration = 0.05;
+    config.dt = 1e-3;
+
+    std::vector<double> reference;
+    int failures = 0;
+    for (size_t workers : {1, 2, 4}) {
+        MonteCarloEnsemble ensemble(workers);
+        CrossbarEnsembleResult result = ensemble.run_crossbars(prototype, nullptr, waveform, config);
+        if (reference.empty()) {
+            reference = result.final_outputs;
+        } else if (result.final_outputs != reference) {
+            size_t differing = 0;
+            for (size_t k = 0; k < reference.size(); ++k) differing += result.final_outputs[k] != reference[k];
+            std::fprintf(stderr, "ensemble_worker_invariance: %zu workers differ from 1 worker in %zu of %zu outputs\n",
+                         workers, differing, reference.size());
+            ++failures;
+        }
+    }
+    if (failures == 0) std::printf("ensemble_worker_invariance: OK\n");
+    return failures == 0 ? 0 : 1;
+}
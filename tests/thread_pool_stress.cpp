@@ -0,0 +1,25 @@
+// Repeated small parallel_for calls back to back: workers still draining one call race the
+// submission of the next, which is where a lost or double-counted chunk would hang the pool
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include "utils/ThreadPool.h"
+
+int main(int argc, char** argv) {
+    size_t calls = argc > 1 ? (size_t)std::strtoull(argv[1], nullptr, 10) : 200000;
+    const size_t count = 16;
+
+    ThreadPool pool(8);
+    std::atomic<size_t> total{0};
+    for (size_t c = 0; c < calls; ++c) {
+        pool.parallel_for(count, [&](size_t, size_t) { total.fetch_add(1, std::memory_order_relaxed); });
+    }
+
+    size_t expected = calls * count;
+    if (total.load() != expected) {
+        std::fprintf(stderr, "thread_pool_stress: ran %zu indices, expected %zu\n", total.load(), expected);
+        return 1;
+    }
+    std::printf("thread_pool_stress: %zu calls of %zu indices OK\n", calls, count);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// start_recording() / stop_recording() while a producer keeps the ring busy, as
+// SimulationWorker does: the stop must return, the file must hold exactly the samples recorded,
+// and none of them may predate the start or follow the stop
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "utils/TraceRecorder.h"
+
+int main() {
+    TraceRecorder recorder;
+    std::string path = "trace_recorder_stop.mrec";
+    std::string err;
+    int failures = 0;
+
+    // A backlog still queued when the recording starts is not part of it
+    for (int k = 0; k < 60000; ++k) recorder.push({-1.0, 1.0, 1e-3, 1e3, 0.5, 0.0});
+    if (!recorder.start_recording(path, err)) {
+        std::fprintf(stderr, "trace_recorder_stop: %s\n", err.c_str());
+        return 1;
+    }
+    for (int k = 0; k < 1000; ++k) recorder.push({(double)k, 1.0, 1e-3, 1e3, 0.5, 0.0});
+    recorder.stop_recording();
+    uint64_t early = 0, late = 0;
+    if (!TraceRecorder::ReadRecording(path, [&](const TraceSample* s, size_t n) {
+            for (size_t k = 0; k < n; ++k) (s[k].t < 0.0 ? early : late) += 1;
+        }, err)) {
+        std::fprintf(stderr, "trace_recorder_stop: %s\n", err.c_str());
+        ++failures;
+    } else if (early != 0 || late != 1000) {
+        std::fprintf(stderr, "trace_recorder_stop: file holds %llu samples from before the start and %llu of 1000 after\n",
+                     (unsigned long long)early, (unsigned long long)late);
+        ++failures;
+    }
+
+    std::atomic<bool> quit{false};
+    std::atomic<uint64_t> pushed{0};   // Sequence number after the last push; t carries it
+    std::thread producer([&] {
+        for (uint64_t seq = 0; !quit.load(std::memory_order_relaxed); ++seq) {
+            recorder.push({(double)seq, 1.0, 1e-3, 1e3, 0.5, 0.0});
+            pushed.store(seq + 1, std::memory_order_release);
+        }
+    });
+
+    for (int round = 0; round < 20 && failures == 0; ++round) {
+        uint64_t before_start = pushed.load(std::memory_order_acquire);
+        if (!recorder.start_recording(path, err)) {
+            std::fprintf(stderr, "trace_recorder_stop: %s\n", err.c_str());
+            failures = 1;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto start = std::chrono::steady_clock::now();
+        recorder.stop_recording();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // The sample in flight may be in the ring before its sequence number is published
+        uint64_t after_stop = pushed.load(std::memory_order_acquire) + 1;
+
+        uint64_t read = 0;
+        double first_t = -1.0, last_t = -1.0;
+        auto on_chunk = [&](const TraceSample* s, size_t n) {
+            if (n == 0) return;
+            if (read == 0) first_t = s[0].t;
+            last_t = s[n - 1].t;
+            read += n;
+        };
+        if (!TraceRecorder::ReadRecording(path, on_chunk, err)) {
+            std::fprintf(stderr, "trace_recorder_stop: %s\n", err.c_str());
+            ++failures;
+        } else if (read != recorder.recorded()) {
+            std::fprintf(stderr, "trace_recorder_stop: file holds %llu samples, recorded() says %llu\n",
+                         (unsigned long long)read, (unsigned long long)recorder.recorded());
+            ++failures;
+        } else if (read > 0 && (first_t < (double)before_start || last_t >= (double)after_stop)) {
+            std::fprintf(stderr, "trace_recorder_stop: file spans samples %g..%g outside the recording %llu..%llu\n",
+                         first_t, last_t, (unsigned long long)before_start, (unsigned long long)after_stop);
+            ++failures;
+        } else if (secs > 1.0) {
+            std::fprintf(stderr, "trace_recorder_stop: stop_recording took %g s\n", secs);
+            ++failures;
+        }
+    }
+
+    quit.store(true);
+    producer.join();
+    std::remove(path.c_str());
+    if (failures == 0) std::printf("trace_recorder_stop: OK\n");
+    return failures == 0 ? 0 : 1;
+}